@@ -0,0 +1,194 @@
+#include "arena.h"
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "complex.h"
+#include "util.h"
+
+#define ARENA_ALIGN FFT_ALIGNMENT
+#define ARENA_MIN_BLOCK ((size_t) 64 * 1024)
+
+static void* default_alloc(void* ctx, const size_t size) {
+    (void) ctx;
+    return malloc(size);
+}
+
+static void default_free(void* ctx, void* ptr) {
+    (void) ctx;
+    free(ptr);
+}
+
+static const struct FFTAllocator default_allocator = {default_alloc, default_free, NULL};
+static struct FFTAllocator current_allocator = {default_alloc, default_free, NULL};
+
+void fft_set_allocator(const struct FFTAllocator* allocator) {
+    current_allocator = allocator != NULL ? *allocator : default_allocator;
+}
+
+const struct FFTAllocator* fft_get_allocator(void) {
+    return &current_allocator;
+}
+
+struct FFTArenaBlock {
+    struct FFTArenaBlock* next;
+    void* raw;          /* as returned by the allocator */
+    char* data;         /* ARENA_ALIGN aligned */
+    size_t size;
+    size_t used;
+};
+
+static size_t align_up(const size_t n) {
+    return (n + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN;
+}
+
+static struct FFTArenaBlock* block_create(const struct FFTAllocator* allocator, const size_t size) {
+    void* raw = allocator->alloc(allocator->ctx, sizeof(struct FFTArenaBlock) + ARENA_ALIGN + size);
+    if (raw == NULL) {
+        return NULL;
+    }
+    struct FFTArenaBlock* block = raw;
+    const uintptr_t start = (uintptr_t) (block + 1);
+    block->next = NULL;
+    block->raw = raw;
+    block->data = (char*) ((start + ARENA_ALIGN - 1) / ARENA_ALIGN * ARENA_ALIGN);
+    block->size = size;
+    block->used = 0;
+    return block;
+}
+
+static void blocks_free(const struct FFTAllocator* allocator, struct FFTArenaBlock* block,
+                        const struct FFTArenaBlock* stop) {
+    while (block != stop) {
+        struct FFTArenaBlock* next = block->next;
+        allocator->free(allocator->ctx, block->raw);
+        block = next;
+    }
+}
+
+struct FFTArena* fft_arena_create(const size_t size, const struct FFTAllocator* allocator) {
+    struct FFTArena* arena = malloc(sizeof(struct FFTArena));
+    if (arena == NULL) {
+        fprintf(stderr, "fft_arena_create failed\n");
+        return NULL;
+    }
+    arena->allocator = allocator != NULL ? *allocator : current_allocator;
+    arena->head = NULL;
+    arena->capacity = 0;
+    if (size > 0) {
+        arena->head = block_create(&arena->allocator, align_up(size));
+        if (arena->head == NULL) {
+            fprintf(stderr, "fft_arena_create failed\n");
+            free(arena);
+            return NULL;
+        }
+        arena->capacity = arena->head->size;
+    }
+    return arena;
+}
+
+void* fft_arena_alloc(struct FFTArena* arena, size_t size) {
+    if (arena == NULL) {
+        return NULL;
+    }
+    size = align_up(size > 0 ? size : 1);
+    struct FFTArenaBlock* head = arena->head;
+    if (head == NULL || head->size - head->used < size) {
+        /* Grow geometrically; the blocks are merged when the arena empties again. */
+        size_t block_size = arena->capacity > ARENA_MIN_BLOCK ? arena->capacity : ARENA_MIN_BLOCK;
+        block_size = block_size > size ? block_size : size;
+        head = block_create(&arena->allocator, block_size);
+        if (head == NULL) {
+            fprintf(stderr, "fft_arena_alloc failed\n");
+            return NULL;
+        }
+        head->next = arena->head;
+        arena->head = head;
+        arena->capacity += block_size;
+    }
+    void* ptr = head->data + head->used;
+    head->used += size;
+    return ptr;
+}
+
+struct Complex* fft_arena_cplx_arr(struct FFTArena* arena, const int N) {
+    return fft_arena_alloc(arena, (size_t) N * sizeof(struct Complex));
+}
+
+struct FFTArenaMark fft_arena_mark(const struct FFTArena* arena) {
+    if (arena == NULL || arena->head == NULL) {
+        return (struct FFTArenaMark){NULL, 0};
+    }
+    const struct FFTArenaMark mark = {arena->head, arena->head->used};
+    return mark;
+}
+
+void fft_arena_release(struct FFTArena* arena, const struct FFTArenaMark mark) {
+    if (arena == NULL) {
+        return;
+    }
+    int empty = mark.used == 0;
+    for (const struct FFTArenaBlock* b = mark.block; b != NULL && empty; b = b->next) {
+        empty = b->next == NULL || b->next->used == 0;
+    }
+    if (empty && arena->head != NULL && arena->head->next != NULL) {
+        fft_arena_reset(arena);
+        return;
+    }
+
+    /* Blocks added after the mark are kept only while the arena is in use, then merged by the reset above. */
+    for (struct FFTArenaBlock* b = arena->head; b != mark.block; b = b->next) {
+        b->used = 0;
+    }
+    if (mark.block != NULL) {
+        mark.block->used = mark.used;
+    }
+}
+
+void fft_arena_reset(struct FFTArena* arena) {
+    if (arena == NULL || arena->head == NULL) {
+        return;
+    }
+    if (arena->head->next != NULL) {
+        blocks_free(&arena->allocator, arena->head, NULL);
+        arena->head = block_create(&arena->allocator, arena->capacity);
+        if (arena->head == NULL) {
+            arena->capacity = 0;
+            return;
+        }
+    }
+    arena->head->used = 0;
+}
+
+void fft_arena_destroy(struct FFTArena* arena) {
+    if (arena == NULL) {
+        return;
+    }
+    blocks_free(&arena->allocator, arena->head, NULL);
+    free(arena);
+}
+
+static pthread_key_t thread_arena_key;
+static pthread_once_t thread_arena_once = PTHREAD_ONCE_INIT;
+
+static void thread_arena_destroy(void* arena) {
+    fft_arena_destroy(arena);
+}
+
+static void thread_arena_key_create(void) {
+    pthread_key_create(&thread_arena_key, thread_arena_destroy);
+}
+
+struct FFTArena* fft_thread_arena(void) {
+    pthread_once(&thread_arena_once, thread_arena_key_create);
+    struct FFTArena* arena = pthread_getspecific(thread_arena_key);
+    if (arena == NULL) {
+        arena = fft_arena_create(0, NULL);
+        if (arena != NULL) {
+            pthread_setspecific(thread_arena_key, arena);
+        }
+    }
+    return arena;
+}
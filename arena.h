@@ -0,0 +1,62 @@
+#ifndef ARENA_H
+#define ARENA_H
+#include <stddef.h>
+
+#include "complex.h"
+
+/*
+ * ALLOCATOR
+ * Where arenas get their memory. Install one with fft_set_allocator (before
+ * any transform runs) to route the library's scratch memory through your own
+ * accounting; the default is malloc / free.
+ */
+struct FFTAllocator {
+    void* (*alloc)(void* ctx, size_t size);
+    void (*free)(void* ctx, void* ptr);
+    void* ctx;
+};
+
+void fft_set_allocator(const struct FFTAllocator* allocator);   /* NULL restores malloc / free */
+
+const struct FFTAllocator* fft_get_allocator(void);
+
+/*
+ * ARENA
+ * Bump allocation of 64-byte aligned scratch. fft_arena_mark / fft_arena_release
+ * bracket the buffers of one transform; releasing back to an empty arena folds
+ * any overflow blocks into one, so after the first transform of a size the
+ * next ones allocate nothing. A NULL arena allocates nothing and releases nothing.
+ */
+struct FFTArenaBlock;
+
+struct FFTArena {
+    struct FFTAllocator allocator;
+    struct FFTArenaBlock* head;     /* block being filled; earlier, full blocks follow */
+    size_t capacity;                /* total size of all blocks */
+};
+
+struct FFTArenaMark {
+    struct FFTArenaBlock* block;
+    size_t used;
+};
+
+/* allocator may be NULL for the one installed by fft_set_allocator. */
+struct FFTArena* fft_arena_create(size_t size, const struct FFTAllocator* allocator);
+
+void* fft_arena_alloc(struct FFTArena* arena, size_t size);
+
+struct Complex* fft_arena_cplx_arr(struct FFTArena* arena, int N);
+
+struct FFTArenaMark fft_arena_mark(const struct FFTArena* arena);
+
+/* Frees everything allocated since mark. */
+void fft_arena_release(struct FFTArena* arena, struct FFTArenaMark mark);
+
+void fft_arena_reset(struct FFTArena* arena);
+
+void fft_arena_destroy(struct FFTArena* arena);
+
+/* The calling thread's arena, created on first use and destroyed when the thread exits. */
+struct FFTArena* fft_thread_arena(void);
+
+#endif //ARENA_H
@@ -0,0 +1,50 @@
+#include "complexf.h"
+
+#include <math.h>
+
+struct ComplexF add_qf(const struct ComplexF x, const struct ComplexF y) {
+    struct ComplexF z;
+    z.real = x.real + y.real;
+    z.imag = x.imag + y.imag;
+    return z;
+}
+
+struct ComplexF sub_qf(const struct ComplexF x, const struct ComplexF y) {
+    struct ComplexF z;
+    z.real = x.real - y.real;
+    z.imag = x.imag - y.imag;
+    return z;
+}
+
+struct ComplexF mul_qf(const struct ComplexF x, const struct ComplexF y) {
+    struct ComplexF z;
+    z.real = x.real * y.real - x.imag * y.imag;
+    z.imag = x.real * y.imag + x.imag * y.real;
+    return z;
+}
+
+struct ComplexF div_qf(const struct ComplexF x, const struct ComplexF y) {
+    struct ComplexF z;
+    const float denominator = y.real * y.real + y.imag * y.imag;
+    z.real = (x.real * y.real + x.imag * y.imag) / denominator;
+    z.imag = (x.imag * y.real - x.real * y.imag) / denominator;
+    return z;
+}
+
+struct ComplexF exp_qf(const double theta) {
+    struct ComplexF z;
+    z.real = (float) cos(theta);
+    z.imag = (float) sin(theta);
+    return z;
+}
+
+struct ComplexF conj_qf(const struct ComplexF x) {
+    struct ComplexF z;
+    z.real = x.real;
+    z.imag = -x.imag;
+    return z;
+}
+
+float amplitude_qf(const struct ComplexF x) {
+    return sqrtf(x.real * x.real + x.imag * x.imag);
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#ifndef COMPLEXF_H
+#define COMPLEXF_H
+
+/* Single-precision counterpart of struct Complex; the _qf operations mirror the _q ones. */
+struct ComplexF {
+    float real;
+    float imag;
+};
+
+struct ComplexF add_qf(struct ComplexF x, struct ComplexF y);
+
+struct ComplexF sub_qf(struct ComplexF x, struct ComplexF y);
+
+struct ComplexF mul_qf(struct ComplexF x, struct ComplexF y);
+
+struct ComplexF div_qf(struct ComplexF x, struct ComplexF y);
+
+/* theta stays double: the angle is the accuracy-critical part of a twiddle factor. */
+struct ComplexF exp_qf(double theta);
+
+struct ComplexF conj_qf(struct ComplexF x);
+
+float amplitude_qf(struct ComplexF x);
+#endif  // COMPLEXF_H
\ No newline at end of file
@@ -0,0 +1,501 @@
+#include "conv.h"
+
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "complex.h"
+#include "plan.h"
+#include "planner.h"
+#include "rfft.h"
+#include "util.h"
+
+/*
+ * Direct summation costs nx * nh multiply-adds; the FFT path about
+ * CONV_FFT_COST * L * (log2(L) + 1) of them, with two transforms and the
+ * pointwise product. Real direct sums are a quarter of the complex work while
+ * the real FFT path only halves, hence the separate constants (measured).
+ */
+#define CONV_FFT_COST 0.5
+#define CONV_FFT_COST_REAL 1.5
+
+static int conv_use_fft(const int nx, const int nh, const int L, const int real) {
+    return (double) nx * nh > (real ? CONV_FFT_COST_REAL : CONV_FFT_COST) * L * (log2(L) + 1);
+}
+
+/* The kernel that turns correlation into convolution: g[m] = conj(h[nh - 1 - m]). */
+static void conv_kernel(const struct Complex* h, const int nh, const enum ConvMode mode, struct Complex* g) {
+    for (int m = 0; m < nh; m++) {
+        g[m] = mode == CONV_CORRELATE ? conj_q(h[nh - 1 - m]) : h[m];
+    }
+}
+
+static struct ConvPlan* conv_plan_alloc(const int nh, const int nx, const int real) {
+    if (nh < 1 || nx < 1) {
+        fprintf(stderr, "conv_plan_create: invalid lengths nx=%d nh=%d\n", nx, nh);
+        return NULL;
+    }
+    struct ConvPlan* plan = calloc(1, sizeof(struct ConvPlan));
+    if (plan == NULL) {
+        fprintf(stderr, "conv_plan_create failed\n");
+        return NULL;
+    }
+    plan->nx = nx;
+    plan->nh = nh;
+    plan->real = real;
+    const int L = next_power_of_two(nx + nh - 1);
+    plan->L = conv_use_fft(nx, nh, L, real) ? L : 0;
+    return plan;
+}
+
+struct ConvPlan* conv_plan_create(const struct Complex* h, const int nh, const int nx, const enum ConvMode mode) {
+    struct ConvPlan* plan = conv_plan_alloc(nh, nx, 0);
+    if (plan == NULL) {
+        return NULL;
+    }
+    const int L = plan->L;
+    if (L == 0) {
+        plan->h = malloc_cplx_arr(nh);
+        if (plan->h == NULL) {
+            conv_plan_destroy(plan);
+            return NULL;
+        }
+        conv_kernel(h, nh, mode, plan->h);
+        return plan;
+    }
+
+    /*
+     * Both directions must share the scrambled order, which fft_plan_get does
+     * not promise (it picks each direction separately), so the pair comes
+     * from the per-algorithm cache.
+     */
+    plan->forward = fft_plan_get_algorithm(L, 0, PLAN_RADIX_4);
+    plan->backward = fft_plan_get_algorithm(L, 1, PLAN_RADIX_4);
+    plan->H = calloc_cplx_arr(L);
+    if (plan->forward == NULL || plan->backward == NULL || plan->H == NULL) {
+        conv_plan_destroy(plan);
+        return NULL;
+    }
+    conv_kernel(h, nh, mode, plan->H);
+    fft_plan_execute_scrambled(plan->forward, plan->H, plan->H);
+    return plan;
+}
+
+struct ConvPlan* conv_plan_create_real(const double* h, const int nh, const int nx, const enum ConvMode mode) {
+    struct ConvPlan* plan = conv_plan_alloc(nh, nx, 1);
+    if (plan == NULL) {
+        return NULL;
+    }
+    const int L = plan->L;
+    plan->h_real = malloc((L > 0 ? L : nh) * sizeof(double));
+    if (plan->h_real == NULL) {
+        fprintf(stderr, "conv_plan_create failed\n");
+        conv_plan_destroy(plan);
+        return NULL;
+    }
+    for (int m = 0; m < nh; m++) {
+        plan->h_real[m] = mode == CONV_CORRELATE ? h[nh - 1 - m] : h[m];
+    }
+    if (L == 0) {
+        return plan;
+    }
+
+    /* h_real doubles as the zero-padded input of the kernel transform, then is dropped. */
+    memset(plan->h_real + nh, 0, (L - nh) * sizeof(double));
+    plan->rforward = rfft_plan_get(L, 0);
+    plan->rbackward = rfft_plan_get(L, 1);
+    plan->H = malloc_cplx_arr(L / 2 + 1);
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct Complex* work = plan->rforward != NULL
+        ? fft_arena_cplx_arr(arena, rfft_plan_work_size(plan->rforward) + 1) : NULL;
+    if (plan->rbackward == NULL || plan->H == NULL || work == NULL) {
+        fft_arena_release(arena, mark);
+        conv_plan_destroy(plan);
+        return NULL;
+    }
+    rfft_plan_execute_r2c(plan->rforward, plan->h_real, plan->H, work);
+    fft_arena_release(arena, mark);
+    free(plan->h_real);
+    plan->h_real = NULL;
+    return plan;
+}
+
+void conv_plan_destroy(struct ConvPlan* plan) {
+    if (plan == NULL) {
+        return;
+    }
+    fft_free(plan->h);
+    free(plan->h_real);
+    fft_free(plan->H);
+    free(plan);
+}
+
+/* Spectra are multiplied with explicit arithmetic so the loop vectorizes. */
+static void conv_multiply(struct Complex* A, const struct Complex* H, const int n) {
+    for (int k = 0; k < n; k++) {
+        const double re = A[k].real * H[k].real - A[k].imag * H[k].imag;
+        const double im = A[k].real * H[k].imag + A[k].imag * H[k].real;
+        A[k].real = re;
+        A[k].imag = im;
+    }
+}
+
+int conv_plan_execute(const struct ConvPlan* plan, const struct Complex* x, struct Complex* y) {
+    const int nx = plan->nx;
+    const int nh = plan->nh;
+    const int ny = nx + nh - 1;
+    if (plan->L == 0) {
+        const struct Complex* g = plan->h;
+        for (int k = 0; k < ny; k++) {
+            const int m_begin = k - nx + 1 > 0 ? k - nx + 1 : 0;
+            const int m_end = k < nh - 1 ? k : nh - 1;
+            double re = 0;
+            double im = 0;
+            for (int m = m_begin; m <= m_end; m++) {
+                const struct Complex a = x[k - m];
+                re += a.real * g[m].real - a.imag * g[m].imag;
+                im += a.real * g[m].imag + a.imag * g[m].real;
+            }
+            y[k] = (struct Complex){re, im};
+        }
+        return 0;
+    }
+
+    const int L = plan->L;
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct Complex* A = fft_arena_cplx_arr(arena, L);
+    if (A == NULL) {
+        fft_arena_release(arena, mark);
+        return -1;
+    }
+    memcpy(A, x, nx * sizeof(struct Complex));
+    memset(A + nx, 0, (L - nx) * sizeof(struct Complex));
+    fft_plan_execute_scrambled(plan->forward, A, A);
+    conv_multiply(A, plan->H, L);
+    fft_plan_execute_scrambled(plan->backward, A, A);
+    memcpy(y, A, ny * sizeof(struct Complex));
+    fft_arena_release(arena, mark);
+    return 0;
+}
+
+int conv_plan_execute_real(const struct ConvPlan* plan, const double* x, double* y) {
+    const int nx = plan->nx;
+    const int nh = plan->nh;
+    const int ny = nx + nh - 1;
+    if (plan->L == 0) {
+        const double* g = plan->h_real;
+        for (int k = 0; k < ny; k++) {
+            const int m_begin = k - nx + 1 > 0 ? k - nx + 1 : 0;
+            const int m_end = k < nh - 1 ? k : nh - 1;
+            double acc = 0;
+            for (int m = m_begin; m <= m_end; m++) {
+                acc += x[k - m] * g[m];
+            }
+            y[k] = acc;
+        }
+        return 0;
+    }
+
+    const int L = plan->L;
+    const int work_f = rfft_plan_work_size(plan->rforward);
+    const int work_b = rfft_plan_work_size(plan->rbackward);
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    double* a = fft_arena_alloc(arena, L * sizeof(double));
+    struct Complex* A = fft_arena_cplx_arr(arena, L / 2 + 1);
+    struct Complex* work = fft_arena_cplx_arr(arena, (work_f > work_b ? work_f : work_b) + 1);
+    if (a == NULL || A == NULL || work == NULL) {
+        fft_arena_release(arena, mark);
+        return -1;
+    }
+    memcpy(a, x, nx * sizeof(double));
+    memset(a + nx, 0, (L - nx) * sizeof(double));
+    rfft_plan_execute_r2c(plan->rforward, a, A, work);
+    conv_multiply(A, plan->H, L / 2 + 1);
+    rfft_plan_execute_c2r(plan->rbackward, A, a, work);
+    memcpy(y, a, ny * sizeof(double));
+    fft_arena_release(arena, mark);
+    return 0;
+}
+
+static struct Complex* conv_once(const struct Complex* x, const int nx, const struct Complex* h, const int nh,
+                                 const enum ConvMode mode) {
+    struct ConvPlan* plan = conv_plan_create(h, nh, nx, mode);
+    if (plan == NULL) {
+        return NULL;
+    }
+    struct Complex* y = malloc_cplx_arr(nx + nh - 1);
+    if (y != NULL && conv_plan_execute(plan, x, y) != 0) {
+        fft_free(y);
+        y = NULL;
+    }
+    conv_plan_destroy(plan);
+    return y;
+}
+
+static double* conv_once_real(const double* x, const int nx, const double* h, const int nh,
+                              const enum ConvMode mode) {
+    struct ConvPlan* plan = conv_plan_create_real(h, nh, nx, mode);
+    if (plan == NULL) {
+        return NULL;
+    }
+    double* y = malloc((nx + nh - 1) * sizeof(double));
+    if (y != NULL && conv_plan_execute_real(plan, x, y) != 0) {
+        free(y);
+        y = NULL;
+    }
+    conv_plan_destroy(plan);
+    return y;
+}
+
+/* Convolution commutes, so the shorter operand becomes the kernel. */
+struct Complex* convolve(const struct Complex* x, const int nx, const struct Complex* h, const int nh) {
+    return nh <= nx ? conv_once(x, nx, h, nh, CONV_CONVOLVE) : conv_once(h, nh, x, nx, CONV_CONVOLVE);
+}
+
+struct Complex* cross_correlate(const struct Complex* x, const int nx, const struct Complex* y, const int ny) {
+    return conv_once(x, nx, y, ny, CONV_CORRELATE);
+}
+
+struct Complex* correlate(const struct Complex* x, const int N) {
+    return conv_once(x, N, x, N, CONV_CORRELATE);
+}
+
+double* convolve_real(const double* x, const int nx, const double* h, const int nh) {
+    return nh <= nx ? conv_once_real(x, nx, h, nh, CONV_CONVOLVE) : conv_once_real(h, nh, x, nx, CONV_CONVOLVE);
+}
+
+double* cross_correlate_real(const double* x, const int nx, const double* y, const int ny) {
+    return conv_once_real(x, nx, y, ny, CONV_CORRELATE);
+}
+
+double* correlate_real(const double* x, const int N) {
+    return conv_once_real(x, N, x, N, CONV_CORRELATE);
+}
+
+/* A += B * H */
+static void conv_multiply_add(struct Complex* A, const struct Complex* B, const struct Complex* H, const int n) {
+    for (int k = 0; k < n; k++) {
+        A[k].real += B[k].real * H[k].real - B[k].imag * H[k].imag;
+        A[k].imag += B[k].real * H[k].imag + B[k].imag * H[k].real;
+    }
+}
+
+/* One stage: kernel h cut into partitions of `partition` taps, processed in blocks of B. */
+static struct FIRFilter* fir_stage_create(const double* h, const int nh, const int B, const int partition,
+                                          const enum FIRMethod method) {
+    struct FIRFilter* filter = calloc(1, sizeof(struct FIRFilter));
+    if (filter == NULL) {
+        fprintf(stderr, "fir_filter_create failed\n");
+        return NULL;
+    }
+    filter->method = method;
+    filter->nh = nh;
+    filter->B = B;
+    filter->P = (nh + partition - 1) / partition;
+    filter->L = next_power_of_two(B + partition - 1);
+    /* The real FFT splits into halves, so keep at least two bins' worth. */
+    if (filter->L < 2) {
+        filter->L = 2;
+    }
+    const int L = filter->L;
+    const int P = filter->P;
+    const int bins = L / 2 + 1;
+
+    filter->rforward = rfft_plan_create(L, 0);
+    filter->rbackward = rfft_plan_create(L, 1);
+    filter->H = malloc_cplx_arr(P * bins);
+    filter->fdl = malloc_cplx_arr(P * bins);
+    filter->X = malloc_cplx_arr(bins);
+    filter->in = malloc(L * sizeof(double));
+    filter->out = malloc(B * sizeof(double));
+    filter->acc = malloc(L * sizeof(double));
+    filter->time = malloc(L * sizeof(double));
+    if (filter->rforward == NULL || filter->rbackward == NULL || filter->H == NULL || filter->fdl == NULL ||
+        filter->X == NULL || filter->in == NULL || filter->out == NULL || filter->acc == NULL || filter->time == NULL) {
+        fprintf(stderr, "fir_filter_create failed\n");
+        fir_filter_destroy(filter);
+        return NULL;
+    }
+    const int work_f = rfft_plan_work_size(filter->rforward);
+    const int work_b = rfft_plan_work_size(filter->rbackward);
+    filter->work = malloc_cplx_arr((work_f > work_b ? work_f : work_b) + 1);
+    if (filter->work == NULL) {
+        fir_filter_destroy(filter);
+        return NULL;
+    }
+
+    /* time doubles as each zero-padded partition. */
+    for (int p = 0; p < P; p++) {
+        const int length = nh - p * partition < partition ? nh - p * partition : partition;
+        memcpy(filter->time, h + p * partition, length * sizeof(double));
+        memset(filter->time + length, 0, (L - length) * sizeof(double));
+        rfft_plan_execute_r2c(filter->rforward, filter->time, filter->H + p * bins, filter->work);
+    }
+    fir_filter_reset(filter);
+    return filter;
+}
+
+struct FIRFilter* fir_filter_create(const double* h, const int nh, const int block, const enum FIRMethod method) {
+    if (nh < 1) {
+        fprintf(stderr, "fir_filter_create: invalid nh=%d\n", nh);
+        return NULL;
+    }
+    return fir_stage_create(h, nh, block > 0 ? block : next_power_of_two(nh), nh, method);
+}
+
+/*
+ * Stage k has block B_k = block * 2^k and is B_k - block samples late
+ * relative to the first stage, so it takes the kernel from tap B_k - block:
+ * one partition per stage while the blocks double, then every remaining tap
+ * in partitions of max_block.
+ */
+struct FIRFilter* fir_filter_create_partitioned(const double* h, const int nh, const int block, const int max_block) {
+    if (nh < 1 || block < 1) {
+        fprintf(stderr, "fir_filter_create_partitioned: invalid nh=%d block=%d\n", nh, block);
+        return NULL;
+    }
+    struct FIRFilter* head = NULL;
+    struct FIRFilter** link = &head;
+    for (int B = block; B - block < nh; B *= 2) {
+        const int start = B - block;
+        const int last = B > max_block / 2 || B > INT_MAX / 2;
+        const int length = last || nh - start < B ? nh - start : B;
+        struct FIRFilter* stage = fir_stage_create(h + start, length, B, B, FIR_OVERLAP_SAVE);
+        if (stage == NULL) {
+            fir_filter_destroy(head);
+            return NULL;
+        }
+        *link = stage;
+        link = &stage->next;
+        if (last) {
+            break;
+        }
+    }
+
+    if (head->next != NULL) {
+        head->stage_out = malloc(block * sizeof(double));
+        head->stage_sum = malloc(block * sizeof(double));
+        if (head->stage_out == NULL || head->stage_sum == NULL) {
+            fprintf(stderr, "fir_filter_create_partitioned failed\n");
+            fir_filter_destroy(head);
+            return NULL;
+        }
+    }
+    head->nh = nh;
+    return head;
+}
+
+void fir_filter_reset(struct FIRFilter* filter) {
+    for (; filter != NULL; filter = filter->next) {
+        memset(filter->in, 0, filter->L * sizeof(double));
+        memset(filter->out, 0, filter->B * sizeof(double));
+        memset(filter->acc, 0, filter->L * sizeof(double));
+        memset(filter->fdl, 0, (size_t) filter->P * (filter->L / 2 + 1) * sizeof(struct Complex));
+        filter->fdl_head = 0;
+        filter->pos = 0;
+    }
+}
+
+void fir_filter_destroy(struct FIRFilter* filter) {
+    while (filter != NULL) {
+        struct FIRFilter* next = filter->next;
+        rfft_plan_destroy(filter->rforward);
+        rfft_plan_destroy(filter->rbackward);
+        fft_free(filter->H);
+        fft_free(filter->fdl);
+        fft_free(filter->X);
+        free(filter->in);
+        free(filter->out);
+        free(filter->acc);
+        free(filter->time);
+        fft_free(filter->work);
+        free(filter->stage_out);
+        free(filter->stage_sum);
+        free(filter);
+        filter = next;
+    }
+}
+
+/* Overlap-save fills the end of its window; overlap-add the start of its padded block. */
+static double* fir_filter_input(const struct FIRFilter* filter) {
+    return filter->method == FIR_OVERLAP_SAVE ? filter->in + filter->L - filter->B : filter->in;
+}
+
+static void fir_filter_block(struct FIRFilter* filter) {
+    const int L = filter->L;
+    const int B = filter->B;
+    const int P = filter->P;
+    const int bins = L / 2 + 1;
+
+    /* Partition p meets the input spectrum from p blocks ago. */
+    struct Complex* newest = filter->fdl + (size_t) filter->fdl_head * bins;
+    rfft_plan_execute_r2c(filter->rforward, filter->in, newest, filter->work);
+    memcpy(filter->X, newest, bins * sizeof(struct Complex));
+    conv_multiply(filter->X, filter->H, bins);
+    for (int p = 1; p < P; p++) {
+        const int slot = filter->fdl_head - p < 0 ? filter->fdl_head - p + P : filter->fdl_head - p;
+        conv_multiply_add(filter->X, filter->fdl + (size_t) slot * bins, filter->H + (size_t) p * bins, bins);
+    }
+    filter->fdl_head = filter->fdl_head + 1 == P ? 0 : filter->fdl_head + 1;
+    rfft_plan_execute_c2r(filter->rbackward, filter->X, filter->time, filter->work);
+
+    if (filter->method == FIR_OVERLAP_SAVE) {
+        /* The first L - B outputs wrapped around; the window slides by one block. */
+        memcpy(filter->out, filter->time + L - B, B * sizeof(double));
+        memmove(filter->in, filter->in + B, (L - B) * sizeof(double));
+        return;
+    }
+
+    double* acc = filter->acc;
+    for (int i = 0; i < L; i++) {
+        acc[i] += filter->time[i];
+    }
+    memcpy(filter->out, acc, B * sizeof(double));
+    memmove(acc, acc + B, (L - B) * sizeof(double));
+    memset(acc + L - B, 0, B * sizeof(double));
+}
+
+static void fir_stage_process(struct FIRFilter* filter, const double* x, const int n, double* y) {
+    const int B = filter->B;
+    double* input = fir_filter_input(filter);
+    for (int i = 0; i < n;) {
+        const int count = n - i < B - filter->pos ? n - i : B - filter->pos;
+        memcpy(input + filter->pos, x + i, count * sizeof(double));
+        memcpy(y + i, filter->out + filter->pos, count * sizeof(double));
+        filter->pos += count;
+        i += count;
+        if (filter->pos == B) {
+            fir_filter_block(filter);
+            filter->pos = 0;
+        }
+    }
+}
+
+void fir_filter_process(struct FIRFilter* filter, const double* x, const int n, double* y) {
+    if (filter->next == NULL) {
+        fir_stage_process(filter, x, n, y);
+        return;
+    }
+    /* Later stages read x before the first stage may overwrite it in place. */
+    const int B = filter->B;
+    for (int i = 0; i < n; i += B) {
+        const int count = n - i < B ? n - i : B;
+        memset(filter->stage_sum, 0, count * sizeof(double));
+        for (struct FIRFilter* stage = filter->next; stage != NULL; stage = stage->next) {
+            fir_stage_process(stage, x + i, count, filter->stage_out);
+            for (int j = 0; j < count; j++) {
+                filter->stage_sum[j] += filter->stage_out[j];
+            }
+        }
+        fir_stage_process(filter, x + i, count, y + i);
+        for (int j = 0; j < count; j++) {
+            y[i + j] += filter->stage_sum[j];
+        }
+    }
+}
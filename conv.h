@@ -0,0 +1,130 @@
+#ifndef CONV_H
+#define CONV_H
+#include "complex.h"
+#include "plan.h"
+#include "rfft.h"
+
+/*
+ * CONVOLUTION
+ * Full linear convolution and correlation: nx + nh - 1 outputs. Short kernels
+ * are summed directly; longer ones are multiplied in the frequency domain at
+ * the smallest power-of-two length that holds the result, which is the
+ * vectorized FFT path.
+ */
+enum ConvMode {
+    CONV_CONVOLVE,      /* y[k] = sum_m x[k - m] * h[m] */
+    CONV_CORRELATE      /* y[k] = sum_n x[n + k - (nh - 1)] * conj(h[n]): lags -(nh - 1) .. nx - 1 */
+};
+
+/*
+ * CONVOLUTION PLAN
+ * A kernel prepared once for signals of length nx: its spectrum is computed
+ * at creation and reused by every execute, so matching one template against
+ * many signals costs two transforms per signal. The transform plans come
+ * from the process-wide caches (planner.h), so creating a ConvPlan only
+ * transforms the kernel. Plans are read-only once created and may be shared
+ * between threads.
+ */
+struct ConvPlan {
+    int nx;                     /* signal length */
+    int nh;                     /* kernel length */
+    int L;                      /* FFT length, power of two >= nx + nh - 1; 0 for direct summation */
+    int real;
+    struct Complex* h;          /* complex direct path: the kernel, reversed and conjugated for correlation */
+    double* h_real;             /* real direct path */
+    struct Complex* H;          /* kernel spectrum: L bins in the forward plan's scrambled order, or L/2 + 1 (real) */
+    const struct FFTPlan* forward;          /* complex plans: one radix-4 pair, so the scrambled orders match */
+    const struct FFTPlan* backward;
+    const struct RealFFTPlan* rforward;     /* real plans */
+    const struct RealFFTPlan* rbackward;
+};
+
+struct ConvPlan* conv_plan_create(const struct Complex* h, int nh, int nx, enum ConvMode mode);
+
+struct ConvPlan* conv_plan_create_real(const double* h, int nh, int nx, enum ConvMode mode);
+
+/* x: nx samples, y: nx + nh - 1 outputs. Scratch comes from the calling thread's arena. -1 on failure. */
+int conv_plan_execute(const struct ConvPlan* plan, const struct Complex* x, struct Complex* y);
+
+int conv_plan_execute_real(const struct ConvPlan* plan, const double* x, double* y);
+
+void conv_plan_destroy(struct ConvPlan* plan);
+
+/* One-shot versions; each returns nx + nh - 1 values. */
+struct Complex* convolve(const struct Complex* x, int nx, const struct Complex* h, int nh);
+
+struct Complex* cross_correlate(const struct Complex* x, int nx, const struct Complex* y, int ny);
+
+/* Autocorrelation, cross_correlate(x, N, x, N): 2N - 1 lags with lag 0 at index N - 1. */
+struct Complex* correlate(const struct Complex* x, int N);
+
+double* convolve_real(const double* x, int nx, const double* h, int nh);
+
+double* cross_correlate_real(const double* x, int nx, const double* y, int ny);
+
+double* correlate_real(const double* x, int N);
+
+/*
+ * STREAMING FILTER
+ * FIR filtering of an unbounded real stream in blocks of B samples with a
+ * precomputed kernel spectrum. Samples can be pushed in chunks of any size;
+ * every output sample is the filtered input from exactly B samples earlier.
+ * All buffers are allocated at creation, so processing never allocates.
+ */
+enum FIRMethod {
+    FIR_OVERLAP_SAVE,   /* transform a sliding window of L samples, keep its last B outputs */
+    FIR_OVERLAP_ADD     /* transform each zero-padded block, add the tails of earlier blocks */
+};
+
+/*
+ * The kernel is cut into P partitions, each transformed at length L. Input
+ * spectra are kept in a frequency-domain delay line (FDL) so every block
+ * costs one forward and one inverse transform plus P spectrum products.
+ * fir_filter_create uses a single partition holding the whole kernel.
+ */
+struct FIRFilter {
+    enum FIRMethod method;
+    int nh;                     /* kernel length */
+    int B;                      /* block size and latency */
+    int P;                      /* partitions */
+    int L;                      /* FFT length, power of two >= B + partition length - 1 */
+    int pos;                    /* samples of the current block received so far */
+    struct Complex* H;          /* P partition spectra of L/2 + 1 bins */
+    struct Complex* fdl;        /* spectra of the last P input blocks, a ring of P x (L/2 + 1) bins */
+    int fdl_head;               /* FDL slot of the newest block */
+    struct RealFFTPlan* rforward;
+    struct RealFFTPlan* rbackward;
+    double* in;                 /* overlap-save: window of the last L inputs; overlap-add: current block, zero-padded to L */
+    double* out;                /* B outputs of the last block, read while the next one fills */
+    double* acc;                /* overlap-add: L partial sums, the first B complete */
+    double* time;               /* L samples of inverse transform output */
+    struct Complex* X;          /* L/2 + 1 bins */
+    struct Complex* work;
+    struct FIRFilter* next;     /* non-uniform partitioning: the stage for the next kernel segment */
+    double* stage_out;          /* B samples each of later stage output and their sum */
+    double* stage_sum;
+};
+
+/* block <= 0 picks B as the power of two >= nh, so L = 2B. */
+struct FIRFilter* fir_filter_create(const double* h, int nh, int block, enum FIRMethod method);
+
+/*
+ * Partitioned convolution for long kernels: latency is one block of `block`
+ * samples whatever nh is. With max_block <= block the kernel is cut into
+ * uniform partitions of `block` taps. A larger max_block makes it
+ * non-uniform: stages with blocks block, 2 block, 4 block, ... up to max_block
+ * each take a later kernel segment, which bounds the FDL length for very long
+ * kernels. A stage computes its whole block when it fills, so the work is
+ * not spread evenly over the small blocks.
+ */
+struct FIRFilter* fir_filter_create_partitioned(const double* h, int nh, int block, int max_block);
+
+/* Filters n samples of x into y (x == y allowed). y[i] is the output for the input B samples before x[i]. */
+void fir_filter_process(struct FIRFilter* filter, const double* x, int n, double* y);
+
+/* Clears the stream history, as if no samples had been pushed. */
+void fir_filter_reset(struct FIRFilter* filter);
+
+void fir_filter_destroy(struct FIRFilter* filter);
+
+#endif //CONV_H
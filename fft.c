@@ -1,51 +1,52 @@
 #include "fft.h"
 
-#include <assert.h>
 #include <math.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "arena.h"
 #include "complex.h"
+#include "plan.h"
+#include "planner.h"
+#include "threads.h"
 #include "util.h"
 
-struct Complex* radix_2_base(struct Complex* x, const int N, const int inverse) {
+/* Transforms x[0], x[stride], ... into X[0..N); the halves land in X and are combined in place, so no scratch is needed. */
+static void radix_2_rec(const struct Complex* x, const int stride, struct Complex* X, const int N, const int inverse) {
     if (N <= 1) {
-        return x;
+        X[0] = x[0];
+        return;
     }
 
     const int half = N / 2;
-    struct Complex* temp_even = malloc_cplx_arr(half);
-    struct Complex* temp_odd = malloc_cplx_arr(half);
-
-    for (int i = 0; i < half; i++) {
-        temp_even[i] = x[2 * i];
-        temp_odd[i] = x[2 * i + 1];
-    }
-
-    // Recursive call, cannot be freed -> error.
-    struct Complex* even = radix_2_base(temp_even, half, inverse);
-    struct Complex* odd = radix_2_base(temp_odd, half, inverse);
-    assert(even != NULL && odd != NULL);
-
-    struct Complex* X = malloc_cplx_arr(N);
+    radix_2_rec(x, 2 * stride, X, half, inverse);
+    radix_2_rec(x + stride, 2 * stride, X + half, half, inverse);
 
     const struct Complex complex_2 = (struct Complex){2, 0};
     for (int k = 0; k < half; k++) {
         const double factor = inverse ? 2.0 : -2.0;
-        const struct Complex t = mul_q(exp_q(factor * M_PI * k / N), odd[k]);
+        const struct Complex even = X[k];
+        const struct Complex t = mul_q(exp_q(factor * M_PI * k / N), X[k + half]);
         if (inverse) {
-            X[k] = div_q(add_q(even[k], t), complex_2);
-            X[k + half] = div_q(sub_q(even[k], t), complex_2);
+            X[k] = div_q(add_q(even, t), complex_2);
+            X[k + half] = div_q(sub_q(even, t), complex_2);
         } else {
-            X[k] = add_q(even[k], t);
-            X[k + half] = sub_q(even[k], t);
+            X[k] = add_q(even, t);
+            X[k + half] = sub_q(even, t);
         }
     }
+}
 
-    free(temp_even);
-    free(temp_odd);
-
+struct Complex* radix_2_base(struct Complex* x, const int N, const int inverse) {
+    struct Complex* X = malloc_cplx_arr(N > 0 ? N : 1);
+    if (X == NULL) {
+        return NULL;
+    }
+    if (N > 0) {
+        radix_2_rec(x, 1, X, N, inverse);
+    }
     return X;
 }
 
@@ -120,38 +121,120 @@ struct Complex * iter_ifft(const struct Complex* x, const int N) {
     return iter_fft_base(x, N, 1);
 }
 
+/* Butterfly stages on bit-reversed data; each twiddle is computed once per stage. */
+static void iter_fft_stages(struct Complex* X, const int N, const int inverse) {
+    const double factor = inverse ? 2.0 : -2.0;
+    for (int m = 2; m <= N; m <<= 1) {
+        const int half = m / 2;
+        for (int j = 0; j < half; j++) {
+            const struct Complex w = exp_q(factor * M_PI * j / m);
+            for (int k = j; k < N; k += m) {
+                const struct Complex t = mul_q(w, X[k + half]);
+                const struct Complex u = X[k];
+                X[k] = add_q(u, t);
+                X[k + half] = sub_q(u, t);
+            }
+        }
+    }
+    if (inverse) {
+        const double scale = 1.0 / N;
+        for (int i = 0; i < N; i++) {
+            X[i].real *= scale;
+            X[i].imag *= scale;
+        }
+    }
+}
+
+void iter_fft_inplace(struct Complex* x, const int N, const int inverse) {
+    int bits = 0;
+    while (1 << bits < N) {
+        bits++;
+    }
+    for (int i = 0; i < N; i++) {
+        const int j = bit_reverse(i, bits);
+        if (i < j) {
+            const struct Complex temp = x[i];
+            x[i] = x[j];
+            x[j] = temp;
+        }
+    }
+    iter_fft_stages(x, N, inverse);
+}
+
+void iter_fft_into(const struct Complex* x, struct Complex* X, const int N, const int inverse) {
+    int bits = 0;
+    while (1 << bits < N) {
+        bits++;
+    }
+    for (int i = 0; i < N; i++) {
+        X[i] = x[bit_reverse(i, bits)];
+    }
+    iter_fft_stages(X, N, inverse);
+}
+
+struct Complex* radix_4_fft_base(const struct Complex* x, const int N, const int inverse) {
+    struct FFTPlan* plan = fft_plan_create_radix(N, inverse, 4);
+    if (plan == NULL) {
+        return NULL;
+    }
+    struct Complex* X = fft_plan_execute(plan, x);
+    fft_plan_destroy(plan);
+    return X;
+}
+
+struct Complex* radix_4_fft(const struct Complex* x, const int N) {
+    return radix_4_fft_base(x, N, 0);
+}
+
+struct Complex* radix_4_ifft(const struct Complex* x, const int N) {
+    return radix_4_fft_base(x, N, 1);
+}
+
 struct Complex * bluestein_fft_base(const struct Complex* x, const int N, const int inverse) {
     const int M = next_power_of_two(2 * N - 1);
 
-    struct Complex* chirp = malloc_cplx_arr(N);
+    struct FFTArena* arena = fft_thread_arena();
+    if (arena == NULL) {
+        return NULL;
+    }
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct Complex* chirp = fft_arena_cplx_arr(arena, N);
+    struct Complex* a = fft_arena_cplx_arr(arena, M);
+    struct Complex* b = fft_arena_cplx_arr(arena, M);
+    struct Complex* X = malloc_cplx_arr(N);
+    if (chirp == NULL || a == NULL || b == NULL || X == NULL) {
+        fft_arena_release(arena, mark);
+        fft_free(X);
+        return NULL;
+    }
 
     const double factor = inverse ? 1.0 : -1.0;
     for (int k = 0; k < N; k++) {
-        const double theta = factor * M_PI * (k * k % (N * 2)) / N;
+        const double theta = factor * M_PI * (double) ((long long) k * k % (2LL * N)) / N;
         chirp[k] = exp_q(theta);
     }
 
-    struct Complex* a = calloc_cplx_arr(M);
-    struct Complex* b = calloc_cplx_arr(M);
-
     for (int k = 0; k < N; k++) {
         a[k] = mul_q(x[k], chirp[k]);
         b[k] = conj_q(chirp[k]);
     }
+    for (int k = N; k < M; k++) {
+        a[k] = (struct Complex){0, 0};
+        b[k] = (struct Complex){0, 0};
+    }
 
     for (int k = N - 1; k > 0; k--) {
         b[M - k] = conj_q(chirp[k]);
     }
 
-    a = iter_fft(a, M);
-    b = iter_fft(b, M);
+    iter_fft_inplace(a, M, 0);
+    iter_fft_inplace(b, M, 0);
 
     for (int k = 0; k < M; k++) {
         a[k] = mul_q(a[k], b[k]);
     }
 
-    a = iter_ifft(a, M);
-    struct Complex* X = malloc_cplx_arr(N);
+    iter_fft_inplace(a, M, 1);
 
     for (int k = 0; k < N; k++) {
         X[k] = mul_q(a[k], chirp[k]);
@@ -163,9 +246,7 @@ struct Complex * bluestein_fft_base(const struct Complex* x, const int N, const
         }
     }
 
-    free(chirp);
-    free(a);
-    free(b);
+    fft_arena_release(arena, mark);
     return X;
 }
 
@@ -177,68 +258,154 @@ struct Complex* bluestein_ifft(const struct Complex* x, const int N) {
     return bluestein_fft_base(x, N, 1);
 }
 
-void fft_2d_col(struct Complex** X, struct Complex** x, const int height, const int width, const int inverse) {
-    struct Complex* col_arr = malloc_cplx_arr(height);
-    for (int j = 0; j < height; j++) {
-        col_arr[j] = x[j][width];
+void fft_2d_col(struct Complex2D* X, const struct Complex2D* x, const int col, const int inverse) {
+    const struct FFTPlan* plan = fft_plan_get(x->height, inverse);
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct Complex* block = fft_arena_cplx_arr(arena, x->height);
+    struct Complex* work = fft_arena_cplx_arr(arena, fft_plan_work_size(plan) + 1);
+    if (block != NULL && work != NULL) {
+        fft_2d_col_block(X, x, col, col + 1, plan, block, work);
     }
-
-    if (inverse) {
-        col_arr = bluestein_ifft(col_arr, height);
-    } else {
-        col_arr = bluestein_fft(col_arr, height);
-    }
-
-    for (int j = 0; j < height; j++) {
-        X[j][width] = col_arr[j];
-    }
-    free(col_arr);
+    fft_arena_release(arena, mark);
 }
 
-struct Complex** fft_2d_base(struct Complex** x, const int height, const int width, const int inverse) {
-    struct Complex** X = malloc_2d_cplx_arr(height, width);
-    struct Complex** temp_X = malloc_2d_cplx_arr(height, width);
-
-    if (inverse) {
-        for (int j = 0; j < width; j++) {
-            fft_2d_col(X, x, height, j, inverse);
-        }
+void fft_2d_col_block(struct Complex2D* X, const struct Complex2D* x, const int col_begin, const int col_end,
+                      const struct FFTPlan* plan, struct Complex* block, struct Complex* work) {
+    const int height = x->height;
+    for (int j0 = col_begin; j0 < col_end; j0 += FFT_2D_COL_BLOCK) {
+        const int cols = col_end - j0 < FFT_2D_COL_BLOCK ? col_end - j0 : FFT_2D_COL_BLOCK;
 
         for (int i = 0; i < height; i++) {
-            memcpy(temp_X[i], X[i],  width * sizeof(struct Complex));
+            const struct Complex* row = cplx_2d_row(x, i) + j0;
+            for (int c = 0; c < cols; c++) {
+                block[c * height + i] = row[c];
+            }
         }
 
-        for (int i = 0; i < height; i++) {
-            X[i] = bluestein_ifft(X[i], width);
-        }
-    } else {
-        for (int i = 0; i < height; i++) {
-            X[i] = bluestein_fft(x[i], width);
+        for (int c = 0; c < cols; c++) {
+            fft_plan_execute_work(plan, block + c * height, block + c * height, work);
         }
 
         for (int i = 0; i < height; i++) {
-            memcpy(temp_X[i], X[i], width * sizeof(struct Complex));
+            struct Complex* row = cplx_2d_row(X, i) + j0;
+            for (int c = 0; c < cols; c++) {
+                row[c] = block[c * height + i];
+            }
         }
+    }
+}
 
-        for (int j = 0; j < width; j++) {
-            fft_2d_col(X, X, height, j, inverse);
+struct Pass2D {
+    struct Complex2D* X;
+    const struct Complex2D* x;
+    const struct FFTPlan* plan;
+    atomic_int failed;
+};
+
+static void fft_2d_rows_range(void* ctx, const int begin, const int end, const int thread) {
+    (void) thread;
+    struct Pass2D* pass = ctx;
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct Complex* work = fft_arena_cplx_arr(arena, fft_plan_work_size(pass->plan) + 1);
+    if (work != NULL) {
+        for (int i = begin; i < end; i++) {
+            fft_plan_execute_work(pass->plan, cplx_2d_row(pass->x, i), cplx_2d_row(pass->X, i), work);
         }
+    } else {
+        atomic_store(&pass->failed, 1);
+    }
+    fft_arena_release(arena, mark);
+}
+
+static void fft_2d_cols_range(void* ctx, const int begin, const int end, const int thread) {
+    (void) thread;
+    struct Pass2D* pass = ctx;
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct Complex* block = fft_arena_cplx_arr(arena, FFT_2D_COL_BLOCK * pass->x->height);
+    struct Complex* work = fft_arena_cplx_arr(arena, fft_plan_work_size(pass->plan) + 1);
+    if (block != NULL && work != NULL) {
+        fft_2d_col_block(pass->X, pass->x, begin, end, pass->plan, block, work);
+    } else {
+        atomic_store(&pass->failed, 1);
     }
+    fft_arena_release(arena, mark);
+}
 
-    free(temp_X);
+int fft_2d_rows(struct Complex2D* X, const struct Complex2D* x, const struct FFTPlan* plan) {
+    struct Pass2D pass = {X, x, plan, 0};
+    parallel_for(x->height, 1, fft_2d_rows_range, &pass);
+    return atomic_load(&pass.failed) ? -1 : 0;
+}
+
+int fft_2d_cols(struct Complex2D* X, const struct Complex2D* x, const struct FFTPlan* plan) {
+    struct Pass2D pass = {X, x, plan, 0};
+    parallel_for(x->width, FFT_2D_COL_BLOCK, fft_2d_cols_range, &pass);
+    return atomic_load(&pass.failed) ? -1 : 0;
+}
+
+struct Complex2D* fft_2d_base(const struct Complex2D* x, const int inverse) {
+    const int height = x->height;
+    const int width = x->width;
+    struct Complex2D* X = malloc_2d_cplx_arr(height, width);
+    const struct FFTPlan* row_plan = fft_plan_get(width, inverse);
+    const struct FFTPlan* col_plan = fft_plan_get(height, inverse);
+    if (X == NULL || row_plan == NULL || col_plan == NULL) {
+        free_2d(X);
+        return NULL;
+    }
+
+    int status;
+    if (inverse) {
+        status = fft_2d_cols(X, x, col_plan);
+        status = status == 0 ? fft_2d_rows(X, X, row_plan) : status;
+    } else {
+        status = fft_2d_rows(X, x, row_plan);
+        status = status == 0 ? fft_2d_cols(X, X, col_plan) : status;
+    }
+    if (status != 0) {
+        fprintf(stderr, "fft_2d failed\n");
+        free_2d(X);
+        return NULL;
+    }
     return X;
 }
 
-struct Complex** fft_2d(struct Complex** x, const int height, const int width) {
-    return fft_2d_base(x, height, width, 0);
+struct Complex2D* fft_2d(const struct Complex2D* x) {
+    return fft_2d_base(x, 0);
 }
 
-struct Complex** ifft_2d(struct Complex** x, const int height, const int width) {
-    return fft_2d_base(x, height, width, 1);
+struct Complex2D* ifft_2d(const struct Complex2D* x) {
+    return fft_2d_base(x, 1);
 }
 
-struct Complex** fft_shift_2d(struct Complex** x, const int height, const int width) {
-    struct Complex** shifted_x = malloc_2d_cplx_arr(height, width);
+struct Complex2D* fft_shift_2d(const struct Complex2D* x) {
+    const int height = x->height;
+    const int width = x->width;
+    struct Complex2D* shifted_x = malloc_2d_cplx_arr(height, width);
+
+    const int half_height = height / 2;
+    const int half_width = width / 2;
+
+    for (int i = 0; i < height; i++) {
+        struct Complex* shifted_row = cplx_2d_row(shifted_x, i);
+        const struct Complex* row = cplx_2d_row(x, (i + half_height) % height);
+        for (int j = 0; j < width; j++) {
+            shifted_row[j] = row[(j + half_width) % width];
+        }
+    }
+
+    return shifted_x;
+}
+
+double* fft_shift_2d_real(const double* x, const int height, const int width) {
+    double* shifted_x = malloc(height * width * sizeof(double));
+    if (shifted_x == NULL) {
+        fprintf(stderr, "fft_shift_2d_real failed\n");
+        return NULL;
+    }
 
     const int half_height = height / 2;
     const int half_width = width / 2;
@@ -247,9 +414,232 @@ struct Complex** fft_shift_2d(struct Complex** x, const int height, const int wi
         for (int j = 0; j < width; j++) {
             const int new_i = (i + half_height) % height;
             const int new_j = (j + half_width) % width;
-            shifted_x[i][j] = x[new_i][new_j];
+            shifted_x[i * width + j] = x[new_i * width + new_j];
         }
     }
 
     return shifted_x;
+}
+
+struct Batch {
+    const struct FFTPlan* plan;
+    const struct Complex* x;
+    int istride;
+    int idist;
+    struct Complex* X;
+    int ostride;
+    int odist;
+    atomic_int failed;      /* set by any range that could not get its scratch */
+};
+
+static void fft_batch_range(void* ctx, const int begin, const int end, const int thread) {
+    (void) thread;
+    struct Batch* batch = ctx;
+    const struct FFTPlan* plan = batch->plan;
+    const int N = plan->N;
+    const int contiguous = batch->istride == 1 && batch->ostride == 1;
+    /* The plan's work buffer, then the gather block for strided layouts. */
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct Complex* work = fft_arena_cplx_arr(arena, fft_plan_work_size(plan) + 1);
+    struct Complex* block = contiguous ? NULL : fft_arena_cplx_arr(arena, FFT_2D_COL_BLOCK * N);
+    if (work == NULL || (!contiguous && block == NULL)) {
+        atomic_store(&batch->failed, 1);
+        fft_arena_release(arena, mark);
+        return;
+    }
+
+    if (contiguous) {
+        for (int b = begin; b < end; b++) {
+            fft_plan_execute_work(plan, batch->x + (size_t) b * batch->idist, batch->X + (size_t) b * batch->odist,
+                                  work);
+        }
+        fft_arena_release(arena, mark);
+        return;
+    }
+    for (int b0 = begin; b0 < end; b0 += FFT_2D_COL_BLOCK) {
+        const int count = end - b0 < FFT_2D_COL_BLOCK ? end - b0 : FFT_2D_COL_BLOCK;
+        for (int k = 0; k < N; k++) {
+            const struct Complex* in = batch->x + (size_t) b0 * batch->idist + (size_t) k * batch->istride;
+            for (int c = 0; c < count; c++) {
+                block[c * N + k] = in[(size_t) c * batch->idist];
+            }
+        }
+        for (int c = 0; c < count; c++) {
+            fft_plan_execute_work(plan, block + c * N, block + c * N, work);
+        }
+        for (int k = 0; k < N; k++) {
+            struct Complex* out = batch->X + (size_t) b0 * batch->odist + (size_t) k * batch->ostride;
+            for (int c = 0; c < count; c++) {
+                out[(size_t) c * batch->odist] = block[c * N + k];
+            }
+        }
+    }
+    fft_arena_release(arena, mark);
+}
+
+int fft_plan_execute_batch(const struct FFTPlan* plan, const int howmany, const struct Complex* x, const int istride,
+                           const int idist, struct Complex* X, const int ostride, const int odist) {
+    if (howmany < 0 || istride < 1 || ostride < 1) {
+        fprintf(stderr, "fft_plan_execute_batch: invalid layout\n");
+        return -1;
+    }
+    struct Batch batch = {plan, x, istride, idist, X, ostride, odist, 0};
+    parallel_for(howmany, FFT_2D_COL_BLOCK, fft_batch_range, &batch);
+    if (atomic_load(&batch.failed)) {
+        fprintf(stderr, "fft_plan_execute_batch failed\n");
+        return -1;
+    }
+    return 0;
+}
+
+static int planned_fft_many(const struct Complex* x, const int N, const int howmany, const int istride,
+                            const int idist, struct Complex* X, const int ostride, const int odist, const int inverse) {
+    const struct FFTPlan* plan = fft_plan_get(N, inverse);
+    if (plan == NULL) {
+        return -1;
+    }
+    return fft_plan_execute_batch(plan, howmany, x, istride, idist, X, ostride, odist);
+}
+
+int fft_many(const struct Complex* x, const int N, const int howmany, const int istride, const int idist,
+             struct Complex* X, const int ostride, const int odist) {
+    return planned_fft_many(x, N, howmany, istride, idist, X, ostride, odist, 0);
+}
+
+int ifft_many(const struct Complex* x, const int N, const int howmany, const int istride, const int idist,
+              struct Complex* X, const int ostride, const int odist) {
+    return planned_fft_many(x, N, howmany, istride, idist, X, ostride, odist, 1);
+}
+
+int fft_four_step_split(const int N) {
+    int n1 = 1;
+    for (int d = 2; (long long) d * d <= N; d++) {
+        if (N % d == 0) {
+            n1 = d;
+        }
+    }
+    return n1 >= FFT_2D_COL_BLOCK ? n1 : 0;
+}
+
+struct FourStep {
+    struct Complex2D* Y;
+    struct Complex* X;
+    const struct FFTPlan* row_plan;
+    const struct Complex* twiddles_hi;  /* W_N1^q, N1 entries */
+    const struct Complex* twiddles_lo;  /* W_N^r, N2 entries */
+    atomic_int failed;
+};
+
+/* Row k1 is multiplied by W_N^(k1*n2) and transformed; k1*n2 = q*N2 + r is tracked without division. */
+static void four_step_rows_range(void* ctx, const int begin, const int end, const int thread) {
+    (void) thread;
+    struct FourStep* step = ctx;
+    const int n2 = step->Y->width;
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct Complex* work = fft_arena_cplx_arr(arena, fft_plan_work_size(step->row_plan) + 1);
+    if (work == NULL) {
+        atomic_store(&step->failed, 1);
+        fft_arena_release(arena, mark);
+        return;
+    }
+    for (int k1 = begin; k1 < end; k1++) {
+        struct Complex* row = cplx_2d_row(step->Y, k1);
+        int q = 0;
+        int r = 0;
+        for (int j = 0; j < n2; j++) {
+            row[j] = mul_q(row[j], mul_q(step->twiddles_hi[q], step->twiddles_lo[r]));
+            r += k1;
+            if (r >= n2) {
+                r -= n2;
+                q++;
+            }
+        }
+        fft_plan_execute_work(step->row_plan, row, row, work);
+    }
+    fft_arena_release(arena, mark);
+}
+
+/* X[k1 + N1*k2] = Y[k1][k2], in FFT_2D_COL_BLOCK square tiles over the rows of Y. */
+static void four_step_transpose_range(void* ctx, const int begin, const int end, const int thread) {
+    (void) thread;
+    const struct FourStep* step = ctx;
+    const int n1 = step->Y->height;
+    const int n2 = step->Y->width;
+    for (int i0 = begin; i0 < end; i0 += FFT_2D_COL_BLOCK) {
+        const int i1 = i0 + FFT_2D_COL_BLOCK < end ? i0 + FFT_2D_COL_BLOCK : end;
+        for (int j0 = 0; j0 < n2; j0 += FFT_2D_COL_BLOCK) {
+            const int j1 = j0 + FFT_2D_COL_BLOCK < n2 ? j0 + FFT_2D_COL_BLOCK : n2;
+            for (int i = i0; i < i1; i++) {
+                const struct Complex* row = cplx_2d_row(step->Y, i);
+                for (int j = j0; j < j1; j++) {
+                    step->X[(size_t) j * n1 + i] = row[j];
+                }
+            }
+        }
+    }
+}
+
+struct Complex* fft_four_step_base(const struct Complex* x, const int N, const int inverse) {
+    const int n1 = fft_four_step_split(N);
+    if (n1 == 0) {
+        fprintf(stderr, "fft_four_step_base: N = %d has no factor >= %d\n", N, FFT_2D_COL_BLOCK);
+        return NULL;
+    }
+    const int n2 = N / n1;
+
+    const struct FFTPlan* col_plan = fft_plan_get(n1, inverse);
+    const struct FFTPlan* row_plan = fft_plan_get(n2, inverse);
+    struct Complex2D* Y = malloc_2d_cplx_arr(n1, n2);
+    struct Complex* X = malloc_cplx_arr(N);
+    struct Complex* twiddles_hi = malloc_cplx_arr(n1);
+    struct Complex* twiddles_lo = malloc_cplx_arr(n2);
+    if (col_plan == NULL || row_plan == NULL || Y == NULL || X == NULL || twiddles_hi == NULL
+        || twiddles_lo == NULL) {
+        fprintf(stderr, "fft_four_step_base failed\n");
+        free_2d(Y);
+        fft_free(X);
+        fft_free(twiddles_hi);
+        fft_free(twiddles_lo);
+        return NULL;
+    }
+
+    const double factor = inverse ? 2.0 : -2.0;
+    for (int q = 0; q < n1; q++) {
+        twiddles_hi[q] = exp_q(factor * M_PI * q / n1);
+    }
+    for (int r = 0; r < n2; r++) {
+        twiddles_lo[r] = exp_q(factor * M_PI * r / N);
+    }
+
+    /* x viewed as an N1 x N2 row-major matrix: x[N2*n1 + n2] = x_view[n1][n2]. */
+    const struct Complex2D x_view = {(struct Complex*) x, n1, n2, n2};
+    struct FourStep step = {Y, X, row_plan, twiddles_hi, twiddles_lo, 0};
+    if (fft_2d_cols(Y, &x_view, col_plan) != 0) {
+        atomic_store(&step.failed, 1);
+    } else {
+        parallel_for(n1, 1, four_step_rows_range, &step);
+    }
+    if (!atomic_load(&step.failed)) {
+        parallel_for(n1, FFT_2D_COL_BLOCK, four_step_transpose_range, &step);
+    }
+
+    free_2d(Y);
+    fft_free(twiddles_hi);
+    fft_free(twiddles_lo);
+    if (atomic_load(&step.failed)) {
+        fprintf(stderr, "fft_four_step_base failed\n");
+        fft_free(X);
+        return NULL;
+    }
+    return X;
+}
+
+struct Complex* fft_four_step(const struct Complex* x, const int N) {
+    return fft_four_step_base(x, N, 0);
+}
+
+struct Complex* ifft_four_step(const struct Complex* x, const int N) {
+    return fft_four_step_base(x, N, 1);
 }
\ No newline at end of file
@@ -1,6 +1,8 @@
 #ifndef FFT_H
 #define FFT_H
 # include "complex.h"
+# include "plan.h"
+# include "util.h"
 
 /* RADIX-2 DIT FFT */
 struct Complex* radix_2_base(struct Complex* x, int N, int inverse);
@@ -23,6 +25,18 @@ struct Complex* iter_fft(const struct Complex* x, int N);
 
 struct Complex* iter_ifft(const struct Complex* x, int N);
 
+/* No heap allocation: transforms x in place, or writes into X (x and X must not overlap). */
+void iter_fft_inplace(struct Complex* x, int N, int inverse);
+
+void iter_fft_into(const struct Complex* x, struct Complex* X, int N, int inverse);
+
+/* RADIX-4 FFT */
+struct Complex* radix_4_fft_base(const struct Complex* x, int N, int inverse);
+
+struct Complex* radix_4_fft(const struct Complex* x, int N);
+
+struct Complex* radix_4_ifft(const struct Complex* x, int N);
+
 /* BLUESTEIN FFT */
 struct Complex * bluestein_fft_base(const struct Complex *x, int N, int inverse);
 
@@ -31,14 +45,78 @@ struct Complex* bluestein_fft(const struct Complex* x, int N);
 struct Complex* bluestein_ifft(const struct Complex* x, int N);
 
 /* 2D FFT */
-void fft_2d_col(struct Complex** X, struct Complex** x, int height, int width, int inverse);
-
-struct Complex** fft_2d_base(struct Complex** x, int height, int width, int inverse);
-
-struct Complex** fft_2d(struct Complex** x, int height, int width);
-
-struct Complex** ifft_2d(struct Complex** x, int height, int width);
-
-struct Complex** fft_shift_2d(struct Complex** x, int height, int width);
+/* Columns per block of the column pass: 16 complex doubles = 4 cache lines of each row. */
+#define FFT_2D_COL_BLOCK 16
+
+void fft_2d_col(struct Complex2D* X, const struct Complex2D* x, int col, int inverse);
+
+/*
+ * Column transforms of columns [col_begin, col_end) of x, written to X (may be x).
+ * Blocks of FFT_2D_COL_BLOCK columns are gathered row by row into contiguous
+ * scratch, transformed as contiguous arrays and scattered back, so every row is
+ * touched a cache line at a time instead of once per column. block must hold
+ * FFT_2D_COL_BLOCK * height elements and work fft_plan_work_size(plan).
+ */
+void fft_2d_col_block(struct Complex2D* X, const struct Complex2D* x, int col_begin, int col_end,
+                      const struct FFTPlan* plan, struct Complex* block, struct Complex* work);
+
+/*
+ * Row / column passes of x into X (may be x), split across the thread pool with per-thread scratch.
+ * -1 if some thread could not get its scratch, leaving X partly transformed.
+ */
+int fft_2d_rows(struct Complex2D* X, const struct Complex2D* x, const struct FFTPlan* plan);
+
+int fft_2d_cols(struct Complex2D* X, const struct Complex2D* x, const struct FFTPlan* plan);
+
+struct Complex2D* fft_2d_base(const struct Complex2D* x, int inverse);
+
+struct Complex2D* fft_2d(const struct Complex2D* x);
+
+struct Complex2D* ifft_2d(const struct Complex2D* x);
+
+struct Complex2D* fft_shift_2d(const struct Complex2D* x);
+
+/* FFT shift of a flat height x width real plane, e.g. the output of to_amplitude_arr_half. */
+double* fft_shift_2d_real(const double* x, int height, int width);
+
+/*
+ * BATCHED FFT
+ * howmany transforms of one plan: signal b reads x[b * idist + k * istride] and
+ * writes X[b * odist + k * ostride], k < plan->N. Contiguous signals are
+ * transformed where they lie; strided ones (e.g. interleaved channels,
+ * stride = howmany and dist = 1) are gathered FFT_2D_COL_BLOCK signals at a
+ * time so every cache line read serves a whole block. Batches are split across
+ * the thread pool. X may be x when both use the same layout. Returns -1 on
+ * failure.
+ */
+int fft_plan_execute_batch(const struct FFTPlan* plan, int howmany, const struct Complex* x, int istride, int idist,
+                           struct Complex* X, int ostride, int odist);
+
+/* Batched fft / ifft through the plan cache. */
+int fft_many(const struct Complex* x, int N, int howmany, int istride, int idist, struct Complex* X, int ostride,
+             int odist);
+
+int ifft_many(const struct Complex* x, int N, int howmany, int istride, int idist, struct Complex* X, int ostride,
+              int odist);
+
+/*
+ * FOUR-STEP FFT
+ * N = N1 * N2 viewed as an N1 x N2 matrix: length-N1 column FFTs, a W_N^(k1*n2)
+ * twiddle multiply fused into the length-N2 row FFTs, then a blocked transpose.
+ * Every pass works on rows or column tiles that fit in cache and runs on the
+ * thread pool, unlike the late stages of a single long transform.
+ */
+/* fft() / ifft() switch to the four-step FFT from these lengths on, when N splits. */
+#define FFT_FOUR_STEP_MIN (1 << 24)
+#define FFT_FOUR_STEP_MIN_THREADED (1 << 20)   /* with fft_get_threads() > 1 */
+
+/* N1: the largest factor <= sqrt(N), or 0 if it is smaller than FFT_2D_COL_BLOCK. */
+int fft_four_step_split(int N);
+
+struct Complex* fft_four_step_base(const struct Complex* x, int N, int inverse);
+
+struct Complex* fft_four_step(const struct Complex* x, int N);
+
+struct Complex* ifft_four_step(const struct Complex* x, int N);
 
 #endif //FFT_H
\ No newline at end of file
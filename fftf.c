@@ -0,0 +1,464 @@
+#include "fftf.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "complex.h"
+#include "complexf.h"
+#include "plan.h"
+#include "planner.h"
+#include "simd.h"
+#include "threads.h"
+#include "util.h"
+#include "utilf.h"
+
+/* mul_qf lives in complexf.c; the butterflies need the multiply inlined. */
+static inline struct ComplexF cmulf(const struct ComplexF a, const struct ComplexF b) {
+    return (struct ComplexF){a.real * b.real - a.imag * b.imag, a.real * b.imag + a.imag * b.real};
+}
+
+/* The stage layout of fft_plan_stages for PLAN_RADIX_4, each twiddle evaluated in double and rounded once. */
+static int planf_stage_twiddles_create(struct FFTPlanF* plan) {
+    const int N = plan->N;
+    plan->stage_twiddles = malloc_cplxf_arr(N);
+    if (plan->stage_twiddles == NULL) {
+        return -1;
+    }
+    const double factor = plan->inverse ? 2.0 : -2.0;
+    struct ComplexF* w = plan->stage_twiddles;
+    int h = 1;
+    if (N > 1 && (N & 0x55555555) == 0) {
+        *w++ = (struct ComplexF){1, 0};
+        h = 2;
+    }
+    for (; 4 * h <= N; h *= 4) {
+        for (int j = 0; j < h; j++) {
+            const double theta = factor * M_PI * j / (4 * h);
+            w[j] = exp_qf(2 * theta);
+            w[h + j] = exp_qf(theta);
+            w[2 * h + j] = exp_qf(3 * theta);
+        }
+        w += 3 * h;
+    }
+    return 0;
+}
+
+/* The chirp kernel's spectrum comes from a double plan, so B carries no float transform error. */
+static int planf_bluestein_create(struct FFTPlanF* plan) {
+    const int N = plan->N;
+    const int M = next_power_of_two(2 * N - 1);
+    plan->M = M;
+    plan->chirp = malloc_cplxf_arr(N);
+    plan->B = malloc_cplxf_arr(M);
+    plan->forward = fft_planf_create(M, 0);
+    struct FFTPlan* kernel_plan = fft_plan_create_algorithm(M, 0, PLAN_RADIX_4);
+    struct Complex* b = calloc_cplx_arr(M);
+    if (plan->chirp == NULL || plan->B == NULL || plan->forward == NULL || kernel_plan == NULL || b == NULL) {
+        fft_plan_destroy(kernel_plan);
+        fft_free(b);
+        return -1;
+    }
+
+    /* k^2 is reduced mod 2N in integers, so the angle keeps full precision for large k. */
+    const double factor = plan->inverse ? 1.0 : -1.0;
+    for (int k = 0; k < N; k++) {
+        const double theta = factor * M_PI * (double) ((long long) k * k % (2LL * N)) / N;
+        const struct Complex chirp = exp_q(theta);
+        plan->chirp[k] = (struct ComplexF){(float) chirp.real, (float) chirp.imag};
+        b[k] = conj_q(chirp);
+        if (k > 0) {
+            b[M - k] = conj_q(chirp);
+        }
+    }
+    fft_plan_execute_inplace(kernel_plan, b);
+    for (int k = 0; k < M; k++) {
+        plan->B[k] = (struct ComplexF){(float) (b[k].real / M), (float) (b[k].imag / M)};
+    }
+    fft_plan_destroy(kernel_plan);
+    fft_free(b);
+    return 0;
+}
+
+struct FFTPlanF* fft_planf_create(const int N, const int inverse) {
+    if (N < 1) {
+        fprintf(stderr, "fft_planf_create: invalid N=%d\n", N);
+        return NULL;
+    }
+    struct FFTPlanF* plan = calloc(1, sizeof(struct FFTPlanF));
+    if (plan == NULL) {
+        fprintf(stderr, "fft_planf_create failed\n");
+        return NULL;
+    }
+    plan->N = N;
+    plan->inverse = inverse;
+
+    if ((N & (N - 1)) != 0) {
+        if (planf_bluestein_create(plan) != 0) {
+            fft_planf_destroy(plan);
+            return NULL;
+        }
+        return plan;
+    }
+    plan->bit_rev = malloc(N * sizeof(int));
+    if (plan->bit_rev == NULL) {
+        fprintf(stderr, "fft_planf_create failed\n");
+        fft_planf_destroy(plan);
+        return NULL;
+    }
+    int bits = 0;
+    while (1 << bits < N) {
+        bits++;
+    }
+    for (int i = 0; i < N; i++) {
+        plan->bit_rev[i] = bit_reverse(i, bits);
+    }
+    if (planf_stage_twiddles_create(plan) != 0) {
+        fft_planf_destroy(plan);
+        return NULL;
+    }
+    return plan;
+}
+
+int fft_planf_work_size(const struct FFTPlanF* plan) {
+    return plan->bit_rev == NULL ? plan->M : 0;
+}
+
+static void radix_2_stagef(struct ComplexF* X, const int N, const int half, const struct ComplexF* w) {
+    if (simd_radix_2_stagef(X, N, half, w)) {
+        return;
+    }
+    for (int k = 0; k < N; k += 2 * half) {
+        for (int j = 0; j < half; j++) {
+            const struct ComplexF t = cmulf(w[j], X[k + j + half]);
+            const struct ComplexF u = X[k + j];
+            X[k + j] = (struct ComplexF){u.real + t.real, u.imag + t.imag};
+            X[k + j + half] = (struct ComplexF){u.real - t.real, u.imag - t.imag};
+        }
+    }
+}
+
+/* As radix_4_stage in plan.c, with w holding the stage's three twiddle legs. */
+static void radix_4_stagef(struct ComplexF* X, const int N, const int h, const struct ComplexF* w,
+                           const int inverse) {
+    if (simd_radix_4_stagef(X, N, h, w, inverse)) {
+        return;
+    }
+    for (int k = 0; k < N; k += 4 * h) {
+        for (int j = 0; j < h; j++) {
+            const struct ComplexF a0 = X[k + j];
+            const struct ComplexF t1 = cmulf(w[j], X[k + j + h]);
+            const struct ComplexF t2 = cmulf(w[h + j], X[k + j + 2 * h]);
+            const struct ComplexF t3 = cmulf(w[2 * h + j], X[k + j + 3 * h]);
+
+            const struct ComplexF s0 = {a0.real + t1.real, a0.imag + t1.imag};
+            const struct ComplexF d0 = {a0.real - t1.real, a0.imag - t1.imag};
+            const struct ComplexF s1 = {t2.real + t3.real, t2.imag + t3.imag};
+            const struct ComplexF d1 = {t2.real - t3.real, t2.imag - t3.imag};
+            /* d1 * -i for the forward transform, d1 * i for the inverse */
+            const struct ComplexF r1 = inverse
+                ? (struct ComplexF){-d1.imag, d1.real}
+                : (struct ComplexF){d1.imag, -d1.real};
+
+            X[k + j] = (struct ComplexF){s0.real + s1.real, s0.imag + s1.imag};
+            X[k + j + h] = (struct ComplexF){d0.real + r1.real, d0.imag + r1.imag};
+            X[k + j + 2 * h] = (struct ComplexF){s0.real - s1.real, s0.imag - s1.imag};
+            X[k + j + 3 * h] = (struct ComplexF){d0.real - r1.real, d0.imag - r1.imag};
+        }
+    }
+}
+
+static void fft_planf_stages(const struct FFTPlanF* plan, struct ComplexF* X) {
+    const int N = plan->N;
+    const struct ComplexF* w = plan->stage_twiddles;
+    int h = 1;
+    if (N > 1 && (N & 0x55555555) == 0) {
+        /* odd log2(N): one radix-2 stage first */
+        radix_2_stagef(X, N, 1, w);
+        w += 1;
+        h = 2;
+    }
+    for (; 4 * h <= N; h *= 4) {
+        radix_4_stagef(X, N, h, w, plan->inverse);
+        w += 3 * h;
+    }
+
+    if (plan->inverse) {
+        const float scale = 1.0f / N;
+        for (int i = 0; i < N; i++) {
+            X[i].real *= scale;
+            X[i].imag *= scale;
+        }
+    }
+}
+
+/*
+ * The inverse convolution reuses the forward M-point plan: with B already
+ * divided by M, ifft(Y) = conj(fft(conj(Y)) / M), and both conjugations fold
+ * into the pointwise loops.
+ */
+static void planf_bluestein_execute(const struct FFTPlanF* plan, const struct ComplexF* x, struct ComplexF* X,
+                                    struct ComplexF* work) {
+    const int N = plan->N;
+    const int M = plan->M;
+    const struct ComplexF* chirp = plan->chirp;
+
+    for (int k = 0; k < N; k++) {
+        work[k] = cmulf(x[k], chirp[k]);
+    }
+    memset(work + N, 0, (M - N) * sizeof(struct ComplexF));
+    fft_planf_execute_work(plan->forward, work, work, NULL);
+    for (int k = 0; k < M; k++) {
+        const struct ComplexF y = cmulf(work[k], plan->B[k]);
+        work[k] = (struct ComplexF){y.real, -y.imag};
+    }
+    fft_planf_execute_work(plan->forward, work, work, NULL);
+
+    const float scale = plan->inverse ? 1.0f / N : 1.0f;
+    for (int k = 0; k < N; k++) {
+        const struct ComplexF y = cmulf((struct ComplexF){work[k].real, -work[k].imag}, chirp[k]);
+        X[k] = (struct ComplexF){y.real * scale, y.imag * scale};
+    }
+}
+
+void fft_planf_execute_work(const struct FFTPlanF* plan, const struct ComplexF* x, struct ComplexF* X,
+                            struct ComplexF* work) {
+    const int N = plan->N;
+    if (plan->bit_rev == NULL) {
+        planf_bluestein_execute(plan, x, X, work);
+        return;
+    }
+    if (x == X) {
+        for (int i = 0; i < N; i++) {
+            const int j = plan->bit_rev[i];
+            if (i < j) {
+                const struct ComplexF temp = X[i];
+                X[i] = X[j];
+                X[j] = temp;
+            }
+        }
+    } else {
+        for (int i = 0; i < N; i++) {
+            X[i] = x[plan->bit_rev[i]];
+        }
+    }
+    fft_planf_stages(plan, X);
+}
+
+void fft_planf_destroy(struct FFTPlanF* plan) {
+    if (plan == NULL) {
+        return;
+    }
+    free(plan->bit_rev);
+    fft_free(plan->stage_twiddles);
+    fft_free(plan->chirp);
+    fft_free(plan->B);
+    fft_planf_destroy(plan->forward);
+    free(plan);
+}
+
+/* Runs the cached plan for (N, inverse) from x into X (which may be x), with work from the thread's arena. */
+static int planned_fftf_into(const struct ComplexF* x, struct ComplexF* X, const int N, const int inverse) {
+    const struct FFTPlanF* plan = fft_planf_get(N, inverse);
+    if (plan == NULL) {
+        return -1;
+    }
+    if (fft_planf_work_size(plan) == 0) {
+        fft_planf_execute_work(plan, x, X, NULL);
+        return 0;
+    }
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct ComplexF* work = fft_arena_alloc(arena, (size_t) fft_planf_work_size(plan) * sizeof(struct ComplexF));
+    if (work == NULL) {
+        fft_arena_release(arena, mark);
+        return -1;
+    }
+    fft_planf_execute_work(plan, x, X, work);
+    fft_arena_release(arena, mark);
+    return 0;
+}
+
+static struct ComplexF* planned_fftf(const struct ComplexF* x, const int N, const int inverse) {
+    if (N < 1) {
+        fprintf(stderr, "fftf: invalid N=%d\n", N);
+        return NULL;
+    }
+    struct ComplexF* X = malloc_cplxf_arr(N);
+    if (X == NULL) {
+        return NULL;
+    }
+    if (planned_fftf_into(x, X, N, inverse) != 0) {
+        fft_free(X);
+        return NULL;
+    }
+    return X;
+}
+
+int iter_fftf_inplace(struct ComplexF* x, const int N, const int inverse) {
+    if (N < 1 || (N & (N - 1)) != 0) {
+        fprintf(stderr, "iter_fftf_inplace: N=%d is not a power of two\n", N);
+        return -1;
+    }
+    return planned_fftf_into(x, x, N, inverse);
+}
+
+struct ComplexF* iter_fftf_base(const struct ComplexF* x, const int N, const int inverse) {
+    if (N < 1 || (N & (N - 1)) != 0) {
+        fprintf(stderr, "iter_fftf_base: N=%d is not a power of two\n", N);
+        return NULL;
+    }
+    return planned_fftf(x, N, inverse);
+}
+
+struct ComplexF* iter_fftf(const struct ComplexF* x, const int N) {
+    return iter_fftf_base(x, N, 0);
+}
+
+struct ComplexF* iter_ifftf(const struct ComplexF* x, const int N) {
+    return iter_fftf_base(x, N, 1);
+}
+
+struct ComplexF* bluestein_fftf_base(const struct ComplexF* x, const int N, const int inverse) {
+    return planned_fftf(x, N, inverse);
+}
+
+struct ComplexF* bluestein_fftf(const struct ComplexF* x, const int N) {
+    return bluestein_fftf_base(x, N, 0);
+}
+
+struct ComplexF* bluestein_ifftf(const struct ComplexF* x, const int N) {
+    return bluestein_fftf_base(x, N, 1);
+}
+
+struct ComplexF* fftf(const struct ComplexF* x, const int N) {
+    return planned_fftf(x, N, 0);
+}
+
+struct ComplexF* ifftf(const struct ComplexF* x, const int N) {
+    return planned_fftf(x, N, 1);
+}
+
+/* Both passes run cached plans, with each task's work buffers taken once from its thread's arena. */
+struct Pass2DF {
+    struct Complex2DF* X;
+    const struct FFTPlanF* row_plan;
+    const struct FFTPlanF* col_plan;
+    atomic_int failed;
+};
+
+static void fft_2df_rows_range(void* ctx, const int begin, const int end, const int thread) {
+    (void) thread;
+    struct Pass2DF* pass = ctx;
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct ComplexF* work = fft_arena_alloc(arena, (size_t) (fft_planf_work_size(pass->row_plan) + 1) *
+                                                   sizeof(struct ComplexF));
+    if (work == NULL) {
+        atomic_store(&pass->failed, 1);
+        fft_arena_release(arena, mark);
+        return;
+    }
+    for (int i = begin; i < end; i++) {
+        struct ComplexF* row = cplxf_2d_row(pass->X, i);
+        fft_planf_execute_work(pass->row_plan, row, row, work);
+    }
+    fft_arena_release(arena, mark);
+}
+
+/* Blocks of FFT_2DF_COL_BLOCK columns are gathered into contiguous scratch, as in fft_2d_col_block. */
+static void fft_2df_cols_range(void* ctx, const int begin, const int end, const int thread) {
+    (void) thread;
+    struct Pass2DF* pass = ctx;
+    const int height = pass->X->height;
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct ComplexF* block = fft_arena_alloc(arena, (size_t) FFT_2DF_COL_BLOCK * height * sizeof(struct ComplexF));
+    struct ComplexF* work = fft_arena_alloc(arena, (size_t) (fft_planf_work_size(pass->col_plan) + 1) *
+                                                   sizeof(struct ComplexF));
+    if (block == NULL || work == NULL) {
+        atomic_store(&pass->failed, 1);
+        fft_arena_release(arena, mark);
+        return;
+    }
+    for (int j0 = begin; j0 < end; j0 += FFT_2DF_COL_BLOCK) {
+        const int cols = end - j0 < FFT_2DF_COL_BLOCK ? end - j0 : FFT_2DF_COL_BLOCK;
+        for (int i = 0; i < height; i++) {
+            const struct ComplexF* row = cplxf_2d_row(pass->X, i) + j0;
+            for (int c = 0; c < cols; c++) {
+                block[c * height + i] = row[c];
+            }
+        }
+        for (int c = 0; c < cols; c++) {
+            fft_planf_execute_work(pass->col_plan, block + c * height, block + c * height, work);
+        }
+        for (int i = 0; i < height; i++) {
+            struct ComplexF* row = cplxf_2d_row(pass->X, i) + j0;
+            for (int c = 0; c < cols; c++) {
+                row[c] = block[c * height + i];
+            }
+        }
+    }
+    fft_arena_release(arena, mark);
+}
+
+struct Complex2DF* fft_2df_base(const struct Complex2DF* x, const int inverse) {
+    const int height = x->height;
+    const int width = x->width;
+    struct Complex2DF* X = malloc_2d_cplxf_arr(height, width);
+    if (X == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < height; i++) {
+        memcpy(cplxf_2d_row(X, i), cplxf_2d_row(x, i), width * sizeof(struct ComplexF));
+    }
+
+    struct Pass2DF pass = {X, fft_planf_get(width, inverse), fft_planf_get(height, inverse), 0};
+    if (pass.row_plan == NULL || pass.col_plan == NULL) {
+        free_2df(X);
+        return NULL;
+    }
+    parallel_for(height, 1, fft_2df_rows_range, &pass);
+    if (!atomic_load(&pass.failed)) {
+        parallel_for(width, FFT_2DF_COL_BLOCK, fft_2df_cols_range, &pass);
+    }
+    if (atomic_load(&pass.failed)) {
+        fprintf(stderr, "fft_2df failed\n");
+        free_2df(X);
+        return NULL;
+    }
+    return X;
+}
+
+struct Complex2DF* fft_2df(const struct Complex2DF* x) {
+    return fft_2df_base(x, 0);
+}
+
+struct Complex2DF* ifft_2df(const struct Complex2DF* x) {
+    return fft_2df_base(x, 1);
+}
+
+struct Complex2DF* fft_shift_2df(const struct Complex2DF* x) {
+    const int height = x->height;
+    const int width = x->width;
+    struct Complex2DF* shifted_x = malloc_2d_cplxf_arr(height, width);
+    if (shifted_x == NULL) {
+        return NULL;
+    }
+
+    const int half_height = height / 2;
+    const int half_width = width / 2;
+
+    for (int i = 0; i < height; i++) {
+        struct ComplexF* shifted_row = cplxf_2d_row(shifted_x, i);
+        const struct ComplexF* row = cplxf_2d_row(x, (i + half_height) % height);
+        for (int j = 0; j < width; j++) {
+            shifted_row[j] = row[(j + half_width) % width];
+        }
+    }
+
+    return shifted_x;
+}
@@ -0,0 +1,77 @@
+#ifndef FFTF_H
+#define FFTF_H
+# include "complexf.h"
+# include "utilf.h"
+
+/*
+ * SINGLE-PRECISION FFT
+ * float counterparts of the iterative radix-2, Bluestein and 2D transforms, for
+ * data that needs ~1e-6 relative accuracy. Twiddles and chirps are evaluated in
+ * double and rounded once, so the error grows only with log2(N).
+ */
+
+/*
+ * FLOAT PLAN
+ * The tables of one length and direction, laid out as in struct FFTPlan: powers
+ * of two run radix-4 stages (plus one radix-2 stage when log2(N) is odd) on
+ * bit-reversed data, any other N runs Bluestein over a power-of-two plan. The
+ * transforms below all execute plans from the cache (fft_planf_get in planner.h).
+ */
+struct FFTPlanF {
+    int N;
+    int inverse;
+    int* bit_rev;                       /* power-of-two N only */
+    struct ComplexF* stage_twiddles;    /* each stage's twiddles in execution order, as in struct FFTPlan */
+    int M;                              /* Bluestein: power-of-two convolution length, >= 2N - 1 */
+    struct ComplexF* chirp;             /* exp(-+i*pi*k^2/N), N entries */
+    struct ComplexF* B;                 /* FFT of the conjugate chirp kernel divided by M, M entries */
+    struct FFTPlanF* forward;           /* M points; the inverse convolution runs it on conjugated data */
+};
+
+struct FFTPlanF* fft_planf_create(int N, int inverse);
+
+/* Elements of work fft_planf_execute_work needs: M for Bluestein, 0 otherwise. */
+int fft_planf_work_size(const struct FFTPlanF* plan);
+
+/* No heap allocation; x and X may be the same buffer. */
+void fft_planf_execute_work(const struct FFTPlanF* plan, const struct ComplexF* x, struct ComplexF* X,
+                            struct ComplexF* work);
+
+void fft_planf_destroy(struct FFTPlanF* plan);
+
+/* ITERATIVE RADIX-2 FFT */
+struct ComplexF* iter_fftf_base(const struct ComplexF* x, int N, int inverse);
+
+struct ComplexF* iter_fftf(const struct ComplexF* x, int N);
+
+struct ComplexF* iter_ifftf(const struct ComplexF* x, int N);
+
+/* No heap allocation once the plan for N is cached. -1 on failure, leaving x untouched. */
+int iter_fftf_inplace(struct ComplexF* x, int N, int inverse);
+
+/* BLUESTEIN FFT */
+/* Any length; powers of two run the plan's radix-4 stages instead, which compute the same transform. */
+struct ComplexF* bluestein_fftf_base(const struct ComplexF* x, int N, int inverse);
+
+struct ComplexF* bluestein_fftf(const struct ComplexF* x, int N);
+
+struct ComplexF* bluestein_ifftf(const struct ComplexF* x, int N);
+
+/* Any length: radix-4 stages for powers of two, Bluestein otherwise. */
+struct ComplexF* fftf(const struct ComplexF* x, int N);
+
+struct ComplexF* ifftf(const struct ComplexF* x, int N);
+
+/* 2D FFT */
+/* Columns per block of the column pass: 32 float complex = 4 cache lines of each row. */
+#define FFT_2DF_COL_BLOCK 32
+
+struct Complex2DF* fft_2df_base(const struct Complex2DF* x, int inverse);
+
+struct Complex2DF* fft_2df(const struct Complex2DF* x);
+
+struct Complex2DF* ifft_2df(const struct Complex2DF* x);
+
+struct Complex2DF* fft_shift_2df(const struct Complex2DF* x);
+
+#endif //FFTF_H
\ No newline at end of file
@@ -4,7 +4,9 @@
 #include <string.h>
 #include <time.h>
 
+#include "planner.h"
 #include "test.h"
+#include "threads.h"
 
 /* Change these to test different cases. */
 const double TEST_ARR[] = {1.0, 2.0, 1.0, -1.0, 1.5};
@@ -25,17 +27,39 @@ const int TEST_ARR_2D_WIDTH = 4; /* height * width should match array length */
 
 void usage() {
     printf("Usage:\n");
-    printf("\tprogram_name [FFT1 | FFT2 | FFT_IMAGE] [algorithm | input_file output_file]\n");
-    printf("\tFor FFT1, specify one of the algorithms: RADIX_2, DFT, ITER_RADIX_2, BLUESTEIN\n");
+    printf("\tprogram_name [FFT1 | FFT2 | FFT_IMAGE | CONV | FIR | STFT | BATCH | FOUR_STEP] [algorithm | input_file output_file]\n");
+    printf("\tFor FFT1, specify one of the algorithms: RADIX_2, DFT, ITER_RADIX_2, RADIX_4, BLUESTEIN, AUTO, FLOAT, STOCKHAM\n");
     printf("\tFor FFT_IMAGE, specify input and output filenames.\n");
+    printf("\tFFT2, FFT_IMAGE, STFT, BATCH and FOUR_STEP take an optional trailing thread count.\n");
+    printf("\tCONV checks convolution against direct sums with mismatched forward / inverse plans.\n");
+    printf("\tFIR checks the streaming filters against convolve_real.\n");
+    printf("\tSTFT checks short-time transforms against direct DFTs and the inverse round trip.\n");
+    printf("\tBATCH checks batched transforms on strided and interleaved layouts against the DFT.\n");
+    printf("\tFOUR_STEP checks the four-step FFT against the DFT or a single plan.\n");
+}
+
+/* Thread count from an optional trailing argument; returns 0 if it is not a positive integer. */
+int parse_threads(const char *arg) {
+    char *end;
+    const long n = strtol(arg, &end, 10);
+    if (*end != '\0' || n < 1 || n > 1024) {
+        return 0;
+    }
+    return (int)n;
 }
 
 int main(const int argc, char *argv[]) {
     enum TestType test_type;
     enum FFTType fft_type = FFT_NONE;
+    int status = 0;
     const char *input_filename = NULL;
     const char *output_filename = NULL;
     const clock_t start_time = clock();
+    /* With a wisdom file, plans are measured once and the choices persist across runs. */
+    const char *wisdom_filename = getenv(WISDOM_ENV);
+    if (wisdom_filename != NULL) {
+        fft_planner_set_mode(PLANNER_MEASURE);
+    }
 
     if (argc < 2) {
         usage();
@@ -48,6 +72,16 @@ int main(const int argc, char *argv[]) {
         test_type = FFT2;
     } else if (strcmp(argv[1], "FFT_IMAGE") == 0) {
         test_type = FFT_IMAGE;
+    } else if (strcmp(argv[1], "CONV") == 0) {
+        test_type = CONV;
+    } else if (strcmp(argv[1], "FIR") == 0) {
+        test_type = FIR;
+    } else if (strcmp(argv[1], "STFT") == 0) {
+        test_type = STFT;
+    } else if (strcmp(argv[1], "BATCH") == 0) {
+        test_type = BATCH;
+    } else if (strcmp(argv[1], "FOUR_STEP") == 0) {
+        test_type = FOUR_STEP;
     } else {
         printf("Invalid test specified.\n");
         usage();
@@ -65,8 +99,16 @@ int main(const int argc, char *argv[]) {
             fft_type = DFT;
         } else if (strcmp(argv[2], "ITER_RADIX_2") == 0) {
             fft_type = ITER_RADIX_2;
+        } else if (strcmp(argv[2], "RADIX_4") == 0) {
+            fft_type = RADIX_4;
         } else if (strcmp(argv[2], "BLUESTEIN") == 0) {
             fft_type = BLUESTEIN;
+        } else if (strcmp(argv[2], "AUTO") == 0) {
+            fft_type = AUTO;
+        } else if (strcmp(argv[2], "FLOAT") == 0) {
+            fft_type = FLOAT;
+        } else if (strcmp(argv[2], "STOCKHAM") == 0) {
+            fft_type = STOCKHAM;
         } else {
             printf("Invalid algorithm specified.\n");
             usage();
@@ -74,23 +116,38 @@ int main(const int argc, char *argv[]) {
         }
     }
 
+    int threads = 1;
+    if (test_type == FFT2 || test_type == STFT || test_type == BATCH
+        || test_type == FOUR_STEP) {
+        if (argc > 3 || (argc == 3 && (threads = parse_threads(argv[2])) == 0)) {
+            usage();
+            return 1;
+        }
+    }
+
     if (test_type == FFT_IMAGE) {
-        if (argc != 4) {
+        if (argc != 4 && argc != 5) {
             usage();
             return 1;
         }
         input_filename = argv[2];
         output_filename = argv[3];
+        if (argc == 5 && (threads = parse_threads(argv[4])) == 0) {
+            usage();
+            return 1;
+        }
     }
+    fft_set_threads(threads);
+
     switch (test_type) {
         case FFT1:
             if (fft_type == RADIX_2) {
                 test_fft(fft_type, TEST_ARR_2P_ALT, TEST_ARR_2P_ALT_SIZE);
-            } else if (fft_type == ITER_RADIX_2) {
+            } else if (fft_type == ITER_RADIX_2 || fft_type == RADIX_4 || fft_type == STOCKHAM) {
                 test_fft(fft_type, TEST_ARR_2P, TEST_ARR_2P_SIZE);
             } else if (fft_type == DFT) {
                 test_fft(fft_type, TEST_ARR_ALT, TEST_ARR_ALT_SIZE);
-            } else if (fft_type == BLUESTEIN) {
+            } else if (fft_type == BLUESTEIN || fft_type == AUTO || fft_type == FLOAT) {
                 test_fft(fft_type, TEST_ARR, TEST_ARR_SIZE);
             } else {
                 printf("Invalid algorithm specified.\n");
@@ -103,10 +160,29 @@ int main(const int argc, char *argv[]) {
         case FFT_IMAGE:
             test_fft_image(input_filename, output_filename);
             break;
+        case CONV:
+            status = test_conv();
+            break;
+        case FIR:
+            status = test_fir();
+            break;
+        case STFT:
+            status = test_stft();
+            break;
+        case BATCH:
+            status = test_batch();
+            break;
+        case FOUR_STEP:
+            status = test_four_step();
+            break;
+    }
+
+    if (wisdom_filename != NULL) {
+        fft_wisdom_export(wisdom_filename);
     }
 
     const clock_t end_time = clock();
     const double elapsed_time = (double)(end_time - start_time) / CLOCKS_PER_SEC;
     printf("Elapsed time: %.4f seconds\n", elapsed_time);
-    return 0;
+    return status;
 }
\ No newline at end of file
@@ -0,0 +1,1203 @@
+#include "plan.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "complex.h"
+#include "simd.h"
+#include "util.h"
+
+/* complex.c's add_q / sub_q / mul_q are out of line; the butterflies need their arithmetic inlined. */
+static inline struct Complex cadd(const struct Complex a, const struct Complex b) {
+    return (struct Complex){a.real + b.real, a.imag + b.imag};
+}
+
+static inline struct Complex csub(const struct Complex a, const struct Complex b) {
+    return (struct Complex){a.real - b.real, a.imag - b.imag};
+}
+
+static inline struct Complex cmul(const struct Complex a, const struct Complex b) {
+    return (struct Complex){a.real * b.real - a.imag * b.imag, a.real * b.imag + a.imag * b.real};
+}
+
+/* Measured cost per point of a mixed-radix transform relative to a radix-4 one, at n log2 n points. */
+#define MIXED_RADIX_COST 3.0
+
+/*
+ * Rader runs two transforms of length N - 1 and Bluestein two of radix-4 length
+ * M >= 2N - 1. A power-of-two N - 1 always wins; a merely 7-smooth one runs the
+ * slower mixed-radix engine and wins only when Bluestein pads N well past 2N.
+ */
+static int rader_beats_bluestein(const int N) {
+    const double n = N - 1;
+    const double m = next_power_of_two(2 * N - 1);
+    const double cost = ((N - 1) & (N - 2)) == 0 ? 1.0 : MIXED_RADIX_COST;
+    return cost * n * log2(n) < m * log2(m);
+}
+
+struct FFTPlan* fft_plan_create(const int N, const int inverse) {
+    if (N >= 1 && (N & (N - 1)) == 0) {
+        return fft_plan_create_algorithm(N, inverse, PLAN_RADIX_4);
+    }
+    if (N >= 1 && largest_prime_factor(N) <= 7) {
+        return fft_plan_create_algorithm(N, inverse, PLAN_MIXED_RADIX);
+    }
+    if (N > 2 && largest_prime_factor(N) == N && largest_prime_factor(N - 1) <= 7 && rader_beats_bluestein(N)) {
+        return fft_plan_create_algorithm(N, inverse, PLAN_RADER);
+    }
+    return fft_plan_create_algorithm(N, inverse, PLAN_BLUESTEIN);
+}
+
+const char* plan_algorithm_name(const enum PlanAlgorithm algorithm) {
+    switch (algorithm) {
+        case PLAN_RADIX_2: return "RADIX_2";
+        case PLAN_RADIX_4: return "RADIX_4";
+        case PLAN_MIXED_RADIX: return "MIXED_RADIX";
+        case PLAN_RADER: return "RADER";
+        case PLAN_BLUESTEIN: return "BLUESTEIN";
+        case PLAN_STOCKHAM: return "STOCKHAM";
+    }
+    return "UNKNOWN";
+}
+
+struct FFTPlan* fft_plan_create_radix(const int N, const int inverse, const int radix) {
+    if (radix != 2 && radix != 4) {
+        fprintf(stderr, "fft_plan_create: unsupported radix %d\n", radix);
+        return NULL;
+    }
+    return fft_plan_create_algorithm(N, inverse, radix == 4 ? PLAN_RADIX_4 : PLAN_RADIX_2);
+}
+
+struct FFTPlan* fft_plan_create_mixed_radix(const int N, const int inverse, const int* radices,
+                                            const int n_radices) {
+    if (n_radices > MAX_FACTORS) {
+        fprintf(stderr, "fft_plan_create: too many radices\n");
+        return NULL;
+    }
+    int product = 1;
+    for (int i = 0; i < n_radices; i++) {
+        const int p = radices[i];
+        if (p != 2 && p != 3 && p != 4 && p != 5 && p != 7) {
+            fprintf(stderr, "fft_plan_create: unsupported radix %d\n", p);
+            return NULL;
+        }
+        product *= p;
+    }
+    if (product != N) {
+        fprintf(stderr, "fft_plan_create: radices do not multiply to N=%d\n", N);
+        return NULL;
+    }
+
+    struct FFTPlan* plan = fft_plan_create_algorithm(N, inverse, PLAN_MIXED_RADIX);
+    if (plan == NULL) {
+        return NULL;
+    }
+    int remaining = N;
+    for (int i = 0; i < n_radices; i++) {
+        remaining /= radices[i];
+        plan->factors[2 * i] = radices[i];
+        plan->factors[2 * i + 1] = remaining;
+    }
+    plan->n_factors = n_radices;
+    return plan;
+}
+
+/* Radix 4 first, then 2, 3, 5, 7, as (radix, remaining length) pairs. Returns 0 if N is not 7-smooth. */
+static int mixed_radix_factorize(int N, int* factors) {
+    int n_factors = 0;
+    int p = 4;
+    while (N > 1) {
+        while (N % p != 0) {
+            switch (p) {
+                case 4: p = 2; break;
+                case 2: p = 3; break;
+                default: p += 2; break;
+            }
+            if (p > 7) {
+                return 0;
+            }
+        }
+        N /= p;
+        factors[2 * n_factors] = p;
+        factors[2 * n_factors + 1] = N;
+        n_factors++;
+    }
+    return n_factors;
+}
+
+/*
+ * Copies the twiddles of each butterfly stage, in execution order, into one
+ * table: half entries per radix-2 stage and 3h per radix-4 stage (the W^2j,
+ * W^j and W^3j legs), so the SIMD kernels load them with unit stride.
+ */
+static int stage_twiddles_create(struct FFTPlan* plan) {
+    const int N = plan->N;
+    plan->stage_twiddles = malloc_cplx_arr(N > 1 ? N : 1);
+    plan->stage_twiddles_split = fft_malloc(2 * (N > 1 ? N : 1) * sizeof(double));
+    if (plan->stage_twiddles == NULL || plan->stage_twiddles_split == NULL) {
+        fprintf(stderr, "fft_plan_create failed\n");
+        return -1;
+    }
+    struct Complex* w = plan->stage_twiddles;
+    int h = 1;
+    if (plan->algorithm == PLAN_RADIX_4) {
+        if (N > 1 && (N & 0x55555555) == 0) {
+            *w++ = plan->twiddles[0];
+            h = 2;
+        }
+        for (; 4 * h <= N; h *= 4) {
+            const int step = N / (4 * h);
+            for (int j = 0; j < h; j++) {
+                w[j] = plan->twiddles[2 * j * step];
+                w[h + j] = plan->twiddles[j * step];
+                w[2 * h + j] = plan->twiddles[3 * j * step];
+            }
+            w += 3 * h;
+        }
+    } else {
+        for (; h < N; h <<= 1) {
+            const int step = N / (2 * h);
+            for (int j = 0; j < h; j++) {
+                w[j] = plan->twiddles[j * step];
+            }
+            w += h;
+        }
+    }
+    for (int k = 0; k < N; k++) {
+        plan->stage_twiddles_split[k] = plan->stage_twiddles[k].real;
+        plan->stage_twiddles_split[N + k] = plan->stage_twiddles[k].imag;
+    }
+    return 0;
+}
+
+struct FFTPlan* fft_plan_create_algorithm(const int N, const int inverse, const enum PlanAlgorithm algorithm) {
+    const int power_of_two = N >= 1 && (N & (N - 1)) == 0;
+    if (N < 1) {
+        fprintf(stderr, "fft_plan_create: invalid N=%d\n", N);
+        return NULL;
+    }
+    if ((algorithm == PLAN_RADIX_2 || algorithm == PLAN_RADIX_4) && !power_of_two) {
+        fprintf(stderr, "fft_plan_create: N=%d is not a power of two\n", N);
+        return NULL;
+    }
+
+    struct FFTPlan* plan = calloc(1, sizeof(struct FFTPlan));
+    if (plan == NULL) {
+        fprintf(stderr, "fft_plan_create failed\n");
+        return NULL;
+    }
+    plan->N = N;
+    plan->inverse = inverse;
+    plan->algorithm = algorithm;
+
+    if (algorithm == PLAN_BLUESTEIN) {
+        plan->bluestein = bluestein_plan_create(N, inverse);
+        if (plan->bluestein == NULL) {
+            fft_plan_destroy(plan);
+            return NULL;
+        }
+        return plan;
+    }
+    if (algorithm == PLAN_RADER) {
+        plan->rader = rader_plan_create(N, inverse);
+        if (plan->rader == NULL) {
+            fft_plan_destroy(plan);
+            return NULL;
+        }
+        return plan;
+    }
+
+    int twiddle_count = N;
+    if (algorithm == PLAN_MIXED_RADIX || algorithm == PLAN_STOCKHAM) {
+        plan->n_factors = mixed_radix_factorize(N, plan->factors);
+        if (plan->n_factors == 0 && N > 1) {
+            fprintf(stderr, "fft_plan_create: N=%d has prime factors larger than 7\n", N);
+            fft_plan_destroy(plan);
+            return NULL;
+        }
+    } else {
+        /* Radix-4 butterflies reach up to W^(3N/4). */
+        twiddle_count = algorithm == PLAN_RADIX_4 ? 3 * N / 4 : N / 2;
+        plan->bit_rev = malloc(N * sizeof(int));
+        if (plan->bit_rev == NULL) {
+            fprintf(stderr, "fft_plan_create failed\n");
+            fft_plan_destroy(plan);
+            return NULL;
+        }
+        int bits = 0;
+        while (1 << bits < N) {
+            bits++;
+        }
+        for (int i = 0; i < N; i++) {
+            plan->bit_rev[i] = bit_reverse(i, bits);
+        }
+    }
+
+    plan->twiddles = malloc_cplx_arr(twiddle_count > 0 ? twiddle_count : 1);
+    if (plan->twiddles == NULL) {
+        fft_plan_destroy(plan);
+        return NULL;
+    }
+    /* Each twiddle is evaluated directly, so there is no drift from a w *= w_m recurrence. */
+    const double factor = inverse ? 2.0 : -2.0;
+    for (int k = 0; k < twiddle_count; k++) {
+        plan->twiddles[k] = exp_q(factor * M_PI * k / N);
+    }
+    if (plan->bit_rev != NULL && stage_twiddles_create(plan) != 0) {
+        fft_plan_destroy(plan);
+        return NULL;
+    }
+    return plan;
+}
+
+static void radix_2_stage(const struct FFTPlan* plan, struct Complex* X, const int half, const struct Complex* w) {
+    const int N = plan->N;
+    if (simd_radix_2_stage(X, N, half, w)) {
+        return;
+    }
+    const int step = N / (2 * half);
+    for (int k = 0; k < N; k += 2 * half) {
+        for (int j = 0; j < half; j++) {
+            const struct Complex t = cmul(plan->twiddles[j * step], X[k + j + half]);
+            const struct Complex u = X[k + j];
+            X[k + j] = cadd(u, t);
+            X[k + j + half] = csub(u, t);
+        }
+    }
+}
+
+/*
+ * Two fused radix-2 stages (spans h and 2h) on bit-reversed data: 3 complex
+ * multiplies per 4 points instead of 4, and one pass over memory instead of two.
+ */
+static void radix_4_stage(const struct FFTPlan* plan, struct Complex* X, const int h, const struct Complex* w) {
+    const int N = plan->N;
+    if (simd_radix_4_stage(X, N, h, w, plan->inverse)) {
+        return;
+    }
+    const int step = N / (4 * h);
+    for (int k = 0; k < N; k += 4 * h) {
+        for (int j = 0; j < h; j++) {
+            const struct Complex a0 = X[k + j];
+            const struct Complex t1 = cmul(plan->twiddles[2 * j * step], X[k + j + h]);
+            const struct Complex t2 = cmul(plan->twiddles[j * step], X[k + j + 2 * h]);
+            const struct Complex t3 = cmul(plan->twiddles[3 * j * step], X[k + j + 3 * h]);
+
+            const struct Complex s0 = cadd(a0, t1);
+            const struct Complex d0 = csub(a0, t1);
+            const struct Complex s1 = cadd(t2, t3);
+            const struct Complex d1 = csub(t2, t3);
+            /* d1 * -i for the forward transform, d1 * i for the inverse */
+            const struct Complex r1 = plan->inverse
+                ? (struct Complex){-d1.imag, d1.real}
+                : (struct Complex){d1.imag, -d1.real};
+
+            X[k + j] = cadd(s0, s1);
+            X[k + j + h] = cadd(d0, r1);
+            X[k + j + 2 * h] = csub(s0, s1);
+            X[k + j + 3 * h] = csub(d0, r1);
+        }
+    }
+}
+
+static void fft_plan_stages(const struct FFTPlan* plan, struct Complex* X) {
+    const int N = plan->N;
+    const struct Complex* w = plan->stage_twiddles;
+    if (plan->algorithm == PLAN_RADIX_4) {
+        int h = 1;
+        if (N > 1 && (N & 0x55555555) == 0) {
+            /* odd log2(N): one radix-2 stage first */
+            radix_2_stage(plan, X, 1, w);
+            w += 1;
+            h = 2;
+        }
+        for (; 4 * h <= N; h *= 4) {
+            radix_4_stage(plan, X, h, w);
+            w += 3 * h;
+        }
+    } else {
+        for (int half = 1; half < N; half <<= 1) {
+            radix_2_stage(plan, X, half, w);
+            w += half;
+        }
+    }
+
+    if (plan->inverse) {
+        const double scale = 1.0 / N;
+        for (int i = 0; i < N; i++) {
+            X[i].real *= scale;
+            X[i].imag *= scale;
+        }
+    }
+}
+
+/*
+ * The transpose of fft_plan_stages (decimation in frequency): natural-order
+ * input, bit-reversed output, with the same stage twiddles applied after the
+ * butterflies and the stages in reverse order. No scaling.
+ */
+static void fft_plan_stages_dif(const struct FFTPlan* plan, struct Complex* X) {
+    const int N = plan->N;
+    int spans[32];
+    int radices[32];
+    const struct Complex* ws[32];
+    int n_stages = 0;
+    const struct Complex* w = plan->stage_twiddles;
+    if (plan->algorithm == PLAN_RADIX_4) {
+        int h = 1;
+        if (N > 1 && (N & 0x55555555) == 0) {
+            spans[n_stages] = 1;
+            radices[n_stages] = 2;
+            ws[n_stages++] = w;
+            w += 1;
+            h = 2;
+        }
+        for (; 4 * h <= N; h *= 4) {
+            spans[n_stages] = h;
+            radices[n_stages] = 4;
+            ws[n_stages++] = w;
+            w += 3 * h;
+        }
+    } else {
+        for (int half = 1; half < N; half <<= 1) {
+            spans[n_stages] = half;
+            radices[n_stages] = 2;
+            ws[n_stages++] = w;
+            w += half;
+        }
+    }
+
+    for (int i = n_stages - 1; i >= 0; i--) {
+        const int h = spans[i];
+        w = ws[i];
+        if (radices[i] == 2) {
+            if (simd_radix_2_stage_dif(X, N, h, w)) {
+                continue;
+            }
+            for (int k = 0; k < N; k += 2 * h) {
+                for (int j = 0; j < h; j++) {
+                    const struct Complex u = X[k + j];
+                    const struct Complex v = X[k + j + h];
+                    X[k + j] = cadd(u, v);
+                    X[k + j + h] = cmul(csub(u, v), w[j]);
+                }
+            }
+            continue;
+        }
+        if (simd_radix_4_stage_dif(X, N, h, w, plan->inverse)) {
+            continue;
+        }
+        for (int k = 0; k < N; k += 4 * h) {
+            for (int j = 0; j < h; j++) {
+                const struct Complex s0 = cadd(X[k + j], X[k + j + 2 * h]);
+                const struct Complex d0 = csub(X[k + j], X[k + j + 2 * h]);
+                const struct Complex s1 = cadd(X[k + j + h], X[k + j + 3 * h]);
+                const struct Complex d1 = csub(X[k + j + h], X[k + j + 3 * h]);
+                const struct Complex r1 = plan->inverse
+                    ? (struct Complex){-d1.imag, d1.real}
+                    : (struct Complex){d1.imag, -d1.real};
+                X[k + j] = cadd(s0, s1);
+                X[k + j + h] = cmul(csub(s0, s1), w[j]);
+                X[k + j + 2 * h] = cmul(cadd(d0, r1), w[h + j]);
+                X[k + j + 3 * h] = cmul(csub(d0, r1), w[2 * h + j]);
+            }
+        }
+    }
+}
+
+/* Twiddled inputs t[0..p-1] of one radix-p butterfly: t[j] = F[j*m] * W^(j*k*fstride). */
+static void load_twiddled(const struct FFTPlan* plan, const struct Complex* F, struct Complex* t, const int p,
+                          const int k, const int fstride, const int m) {
+    t[0] = F[0];
+    for (int j = 1; j < p; j++) {
+        t[j] = cmul(F[j * m], plan->twiddles[j * k * fstride]);
+    }
+}
+
+static void butterfly_2(const struct FFTPlan* plan, struct Complex* F, const int fstride, const int m) {
+    for (int k = 0; k < m; k++) {
+        const struct Complex t = cmul(F[k + m], plan->twiddles[k * fstride]);
+        F[k + m] = csub(F[k], t);
+        F[k] = cadd(F[k], t);
+    }
+}
+
+/*
+ * In-place radix-p DFTs of t[0..p-1], shared by the mixed-radix butterflies
+ * and the Stockham passes. w1.. are W_p^1.. from the plan's twiddles.
+ */
+static inline void dft_2(struct Complex* t) {
+    const struct Complex u = t[0];
+    t[0] = cadd(u, t[1]);
+    t[1] = csub(u, t[1]);
+}
+
+static inline void dft_4(struct Complex* t, const int inverse) {
+    const struct Complex s0 = cadd(t[0], t[2]);
+    const struct Complex d0 = csub(t[0], t[2]);
+    const struct Complex s1 = cadd(t[1], t[3]);
+    const struct Complex d1 = csub(t[1], t[3]);
+    /* d1 * -i for the forward transform, d1 * i for the inverse */
+    const struct Complex r1 = inverse
+        ? (struct Complex){-d1.imag, d1.real}
+        : (struct Complex){d1.imag, -d1.real};
+    t[0] = cadd(s0, s1);
+    t[1] = cadd(d0, r1);
+    t[2] = csub(s0, s1);
+    t[3] = csub(d0, r1);
+}
+
+/*
+ * Odd radices pair inputs j and p - j: with s = t[j] + t[p-j] and d = t[j] - t[p-j],
+ * output u is t[0] + sum(s * Re(W_p^(uj))) +- i * sum(d * Im(W_p^(uj))).
+ */
+static inline void dft_3(struct Complex* t, const struct Complex w1) {
+    const struct Complex s1 = cadd(t[1], t[2]);
+    const struct Complex d1 = csub(t[1], t[2]);
+    const struct Complex a1 = {t[0].real + s1.real * w1.real, t[0].imag + s1.imag * w1.real};
+    const struct Complex b1 = {-d1.imag * w1.imag, d1.real * w1.imag};
+    t[0] = cadd(t[0], s1);
+    t[1] = cadd(a1, b1);
+    t[2] = csub(a1, b1);
+}
+
+static inline void dft_5(struct Complex* t, const struct Complex w1, const struct Complex w2) {
+    const struct Complex s1 = cadd(t[1], t[4]);
+    const struct Complex d1 = csub(t[1], t[4]);
+    const struct Complex s2 = cadd(t[2], t[3]);
+    const struct Complex d2 = csub(t[2], t[3]);
+
+    const struct Complex a1 = {
+        t[0].real + s1.real * w1.real + s2.real * w2.real,
+        t[0].imag + s1.imag * w1.real + s2.imag * w2.real
+    };
+    const struct Complex a2 = {
+        t[0].real + s1.real * w2.real + s2.real * w1.real,
+        t[0].imag + s1.imag * w2.real + s2.imag * w1.real
+    };
+    const double b1_real = d1.real * w1.imag + d2.real * w2.imag;
+    const double b1_imag = d1.imag * w1.imag + d2.imag * w2.imag;
+    const double b2_real = d1.real * w2.imag - d2.real * w1.imag;
+    const double b2_imag = d1.imag * w2.imag - d2.imag * w1.imag;
+    const struct Complex b1 = {-b1_imag, b1_real};
+    const struct Complex b2 = {-b2_imag, b2_real};
+
+    t[0] = cadd(t[0], cadd(s1, s2));
+    t[1] = cadd(a1, b1);
+    t[4] = csub(a1, b1);
+    t[2] = cadd(a2, b2);
+    t[3] = csub(a2, b2);
+}
+
+static inline void dft_7(struct Complex* t, const struct Complex w1, const struct Complex w2,
+                         const struct Complex w3) {
+    const struct Complex s1 = cadd(t[1], t[6]);
+    const struct Complex d1 = csub(t[1], t[6]);
+    const struct Complex s2 = cadd(t[2], t[5]);
+    const struct Complex d2 = csub(t[2], t[5]);
+    const struct Complex s3 = cadd(t[3], t[4]);
+    const struct Complex d3 = csub(t[3], t[4]);
+
+    /* W^4 = conj(W^3), W^5 = conj(W^2), W^6 = conj(W^1) */
+    const struct Complex a1 = {
+        t[0].real + s1.real * w1.real + s2.real * w2.real + s3.real * w3.real,
+        t[0].imag + s1.imag * w1.real + s2.imag * w2.real + s3.imag * w3.real
+    };
+    const struct Complex a2 = {
+        t[0].real + s1.real * w2.real + s2.real * w3.real + s3.real * w1.real,
+        t[0].imag + s1.imag * w2.real + s2.imag * w3.real + s3.imag * w1.real
+    };
+    const struct Complex a3 = {
+        t[0].real + s1.real * w3.real + s2.real * w1.real + s3.real * w2.real,
+        t[0].imag + s1.imag * w3.real + s2.imag * w1.real + s3.imag * w2.real
+    };
+    const double b1_real = d1.real * w1.imag + d2.real * w2.imag + d3.real * w3.imag;
+    const double b1_imag = d1.imag * w1.imag + d2.imag * w2.imag + d3.imag * w3.imag;
+    const double b2_real = d1.real * w2.imag - d2.real * w3.imag - d3.real * w1.imag;
+    const double b2_imag = d1.imag * w2.imag - d2.imag * w3.imag - d3.imag * w1.imag;
+    const double b3_real = d1.real * w3.imag - d2.real * w1.imag + d3.real * w2.imag;
+    const double b3_imag = d1.imag * w3.imag - d2.imag * w1.imag + d3.imag * w2.imag;
+    const struct Complex b1 = {-b1_imag, b1_real};
+    const struct Complex b2 = {-b2_imag, b2_real};
+    const struct Complex b3 = {-b3_imag, b3_real};
+
+    t[0] = cadd(t[0], cadd(s1, cadd(s2, s3)));
+    t[1] = cadd(a1, b1);
+    t[6] = csub(a1, b1);
+    t[2] = cadd(a2, b2);
+    t[5] = csub(a2, b2);
+    t[3] = cadd(a3, b3);
+    t[4] = csub(a3, b3);
+}
+
+/* Radix-p butterflies of the recursive mixed-radix engine: F[k + j*m] for j < p, twiddled by W^(j*k*fstride). */
+static void butterfly_4(const struct FFTPlan* plan, struct Complex* F, const int fstride, const int m) {
+    struct Complex t[4];
+    for (int k = 0; k < m; k++) {
+        load_twiddled(plan, F + k, t, 4, k, fstride, m);
+        dft_4(t, plan->inverse);
+        for (int j = 0; j < 4; j++) {
+            F[k + j * m] = t[j];
+        }
+    }
+}
+
+static void butterfly_3(const struct FFTPlan* plan, struct Complex* F, const int fstride, const int m) {
+    const struct Complex w1 = plan->twiddles[fstride * m];
+    struct Complex t[3];
+    for (int k = 0; k < m; k++) {
+        load_twiddled(plan, F + k, t, 3, k, fstride, m);
+        dft_3(t, w1);
+        for (int j = 0; j < 3; j++) {
+            F[k + j * m] = t[j];
+        }
+    }
+}
+
+static void butterfly_5(const struct FFTPlan* plan, struct Complex* F, const int fstride, const int m) {
+    const struct Complex w1 = plan->twiddles[fstride * m];
+    const struct Complex w2 = plan->twiddles[2 * fstride * m];
+    struct Complex t[5];
+    for (int k = 0; k < m; k++) {
+        load_twiddled(plan, F + k, t, 5, k, fstride, m);
+        dft_5(t, w1, w2);
+        for (int j = 0; j < 5; j++) {
+            F[k + j * m] = t[j];
+        }
+    }
+}
+
+static void butterfly_7(const struct FFTPlan* plan, struct Complex* F, const int fstride, const int m) {
+    const struct Complex w1 = plan->twiddles[fstride * m];
+    const struct Complex w2 = plan->twiddles[2 * fstride * m];
+    const struct Complex w3 = plan->twiddles[3 * fstride * m];
+    struct Complex t[7];
+    for (int k = 0; k < m; k++) {
+        load_twiddled(plan, F + k, t, 7, k, fstride, m);
+        dft_7(t, w1, w2, w3);
+        for (int j = 0; j < 7; j++) {
+            F[k + j * m] = t[j];
+        }
+    }
+}
+
+/*
+ * Recursive decimation-in-time Cooley-Tukey over the factor list. The p
+ * sub-transforms of length m are written contiguously into X and then combined
+ * in place by one radix-p butterfly pass, so no scratch memory is needed.
+ */
+static void mixed_radix_work(const struct FFTPlan* plan, struct Complex* X, const struct Complex* x,
+                             const int fstride, const int in_stride, const int* factors) {
+    const int p = factors[0];
+    const int m = factors[1];
+
+    if (m == 1) {
+        for (int q = 0; q < p; q++) {
+            X[q] = x[q * fstride * in_stride];
+        }
+    } else {
+        for (int q = 0; q < p; q++) {
+            mixed_radix_work(plan, X + q * m, x + q * fstride * in_stride, fstride * p, in_stride, factors + 2);
+        }
+    }
+
+    switch (p) {
+        case 2: butterfly_2(plan, X, fstride, m); break;
+        case 3: butterfly_3(plan, X, fstride, m); break;
+        case 4: butterfly_4(plan, X, fstride, m); break;
+        case 5: butterfly_5(plan, X, fstride, m); break;
+        default: butterfly_7(plan, X, fstride, m); break;
+    }
+}
+
+static void mixed_radix_execute(const struct FFTPlan* plan, const struct Complex* x, struct Complex* X) {
+    const int N = plan->N;
+    if (N == 1) {
+        X[0] = x[0];
+        return;
+    }
+    mixed_radix_work(plan, X, x, 1, 1, plan->factors);
+
+    if (plan->inverse) {
+        const double scale = 1.0 / N;
+        for (int i = 0; i < N; i++) {
+            X[i].real *= scale;
+            X[i].imag *= scale;
+        }
+    }
+}
+
+/*
+ * One Stockham autosort pass over n = p * m points at stride s:
+ * y[q + s*(p*j + r)] = W_n^(r*j) * DFT_p(x[q + s*(j + k*m)], k < p)[r].
+ * The output of every pass is already in order for the next, so the
+ * transform needs no bit-reversal, at the price of ping-ponging buffers.
+ */
+static void stockham_stage(const struct FFTPlan* plan, const struct Complex* x, struct Complex* y, const int p,
+                           const int m, const int s) {
+    if (simd_stockham_stage(x, y, p, m, s, plan->twiddles, plan->inverse)) {
+        return;
+    }
+    const int N = plan->N;
+    const struct Complex w1 = plan->twiddles[N / p];
+    const struct Complex w2 = p > 3 ? plan->twiddles[2 * N / p] : w1;
+    const struct Complex w3 = p > 5 ? plan->twiddles[3 * N / p] : w1;
+    struct Complex t[7];
+    struct Complex w[7];
+    for (int j = 0; j < m; j++) {
+        for (int r = 1; r < p; r++) {
+            w[r] = plan->twiddles[r * j * s];
+        }
+        const struct Complex* xj = x + s * j;
+        struct Complex* yj = y + s * p * j;
+        for (int q = 0; q < s; q++) {
+            for (int k = 0; k < p; k++) {
+                t[k] = xj[q + k * s * m];
+            }
+            switch (p) {
+                case 2: dft_2(t); break;
+                case 3: dft_3(t, w1); break;
+                case 4: dft_4(t, plan->inverse); break;
+                case 5: dft_5(t, w1, w2); break;
+                default: dft_7(t, w1, w2, w3); break;
+            }
+            yj[q] = t[0];
+            for (int r = 1; r < p; r++) {
+                yj[q + r * s] = j > 0 ? cmul(t[r], w[r]) : t[r];
+            }
+        }
+    }
+}
+
+/* x may be X; work holds N elements. Passes alternate between X and work so that the last one writes X. */
+static void stockham_execute(const struct FFTPlan* plan, const struct Complex* x, struct Complex* X,
+                             struct Complex* work) {
+    const int N = plan->N;
+    if (N == 1) {
+        X[0] = x[0];
+        return;
+    }
+    struct Complex* dst = plan->n_factors % 2 == 1 ? X : work;
+    if (x == X && dst == X) {
+        memcpy(work, x, N * sizeof(struct Complex));
+        x = work;
+    }
+    const struct Complex* src = x;
+    int s = 1;
+    for (int i = 0; i < plan->n_factors; i++) {
+        const int p = plan->factors[2 * i];
+        stockham_stage(plan, src, dst, p, plan->factors[2 * i + 1], s);
+        src = dst;
+        dst = dst == X ? work : X;
+        s *= p;
+    }
+
+    if (plan->inverse) {
+        const double scale = 1.0 / N;
+        for (int i = 0; i < N; i++) {
+            X[i].real *= scale;
+            X[i].imag *= scale;
+        }
+    }
+}
+
+int fft_plan_work_size(const struct FFTPlan* plan) {
+    switch (plan->algorithm) {
+        case PLAN_MIXED_RADIX:
+        case PLAN_STOCKHAM:
+            return plan->N;
+        case PLAN_RADER:
+            return rader_plan_work_size(plan->rader);
+        case PLAN_BLUESTEIN:
+            return plan->bluestein->M;
+        default:
+            return 0;
+    }
+}
+
+void fft_plan_execute_work(const struct FFTPlan* plan, const struct Complex* x, struct Complex* X,
+                           struct Complex* work) {
+    const int N = plan->N;
+    switch (plan->algorithm) {
+        case PLAN_RADIX_2:
+        case PLAN_RADIX_4:
+            if (x == X) {
+                for (int i = 0; i < N; i++) {
+                    const int j = plan->bit_rev[i];
+                    if (i < j) {
+                        const struct Complex temp = X[i];
+                        X[i] = X[j];
+                        X[j] = temp;
+                    }
+                }
+            } else {
+                for (int i = 0; i < N; i++) {
+                    X[i] = x[plan->bit_rev[i]];
+                }
+            }
+            fft_plan_stages(plan, X);
+            break;
+        case PLAN_MIXED_RADIX:
+            if (x == X) {
+                memcpy(work, x, N * sizeof(struct Complex));
+                x = work;
+            }
+            mixed_radix_execute(plan, x, X);
+            break;
+        case PLAN_STOCKHAM:
+            stockham_execute(plan, x, X, work);
+            break;
+        case PLAN_RADER:
+            rader_plan_execute_into(plan->rader, x, X, work);
+            break;
+        case PLAN_BLUESTEIN:
+            bluestein_plan_execute_into(plan->bluestein, x, X, work);
+            break;
+    }
+}
+
+/* Runs fft_plan_execute_work, taking the work buffer from the thread's arena only if the plan needs one. */
+static void fft_plan_execute_alloc(const struct FFTPlan* plan, const struct Complex* x, struct Complex* X) {
+    const int needs_work = fft_plan_work_size(plan) > 0 && (plan->algorithm != PLAN_MIXED_RADIX || x == X);
+    if (!needs_work) {
+        fft_plan_execute_work(plan, x, X, NULL);
+        return;
+    }
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct Complex* work = fft_arena_cplx_arr(arena, fft_plan_work_size(plan));
+    if (work != NULL) {
+        fft_plan_execute_work(plan, x, X, work);
+    }
+    fft_arena_release(arena, mark);
+}
+
+struct Complex* fft_plan_execute(const struct FFTPlan* plan, const struct Complex* x) {
+    struct Complex* X = malloc_cplx_arr(plan->N);
+    if (X == NULL) {
+        return NULL;
+    }
+    fft_plan_execute_alloc(plan, x, X);
+    return X;
+}
+
+void fft_plan_execute_inplace(const struct FFTPlan* plan, struct Complex* x) {
+    fft_plan_execute_alloc(plan, x, x);
+}
+
+void fft_plan_execute_into(const struct FFTPlan* plan, const struct Complex* x, struct Complex* X) {
+    fft_plan_execute_alloc(plan, x, X);
+}
+
+void fft_plan_execute_scrambled(const struct FFTPlan* plan, const struct Complex* x, struct Complex* X) {
+    if (plan->bit_rev == NULL) {
+        fft_plan_execute_alloc(plan, x, X);
+        return;
+    }
+    if (x != X) {
+        memcpy(X, x, plan->N * sizeof(struct Complex));
+    }
+    if (plan->inverse) {
+        fft_plan_stages(plan, X);
+    } else {
+        fft_plan_stages_dif(plan, X);
+    }
+}
+
+int fft_plan_scrambled_order(const struct FFTPlan* plan) {
+    return plan->bit_rev != NULL;
+}
+
+void fft_plan_destroy(struct FFTPlan* plan) {
+    if (plan == NULL) {
+        return;
+    }
+    free(plan->bit_rev);
+    fft_free(plan->twiddles);
+    fft_free(plan->stage_twiddles);
+    fft_free(plan->stage_twiddles_split);
+    rader_plan_destroy(plan->rader);
+    bluestein_plan_destroy(plan->bluestein);
+    free(plan);
+}
+
+/* Radix-2 stage on split arrays; w_re / w_im as the plan's stage twiddles. */
+static void radix_2_stage_split(double* re, double* im, const int N, const int half, const double* w_re,
+                                const double* w_im) {
+    if (simd_radix_2_stage_split(re, im, N, half, w_re, w_im)) {
+        return;
+    }
+    for (int k = 0; k < N; k += 2 * half) {
+        for (int j = 0; j < half; j++) {
+            const int a = k + j;
+            const int b = k + j + half;
+            const double t_re = re[b] * w_re[j] - im[b] * w_im[j];
+            const double t_im = re[b] * w_im[j] + im[b] * w_re[j];
+            re[b] = re[a] - t_re;
+            im[b] = im[a] - t_im;
+            re[a] += t_re;
+            im[a] += t_im;
+        }
+    }
+}
+
+/* radix_4_stage on split arrays; the inverse only swaps which of legs 1 and 3 gets d0 + d1*-i. */
+static void radix_4_stage_split(double* re, double* im, const int N, const int h, const double* w_re,
+                                const double* w_im, const int inverse) {
+    if (simd_radix_4_stage_split(re, im, N, h, w_re, w_im, inverse)) {
+        return;
+    }
+    for (int k = 0; k < N; k += 4 * h) {
+        for (int j = 0; j < h; j++) {
+            const int i0 = k + j;
+            const int i1 = i0 + h;
+            const int i2 = i0 + 2 * h;
+            const int i3 = i0 + 3 * h;
+            const double t1_re = re[i1] * w_re[j] - im[i1] * w_im[j];
+            const double t1_im = re[i1] * w_im[j] + im[i1] * w_re[j];
+            const double t2_re = re[i2] * w_re[h + j] - im[i2] * w_im[h + j];
+            const double t2_im = re[i2] * w_im[h + j] + im[i2] * w_re[h + j];
+            const double t3_re = re[i3] * w_re[2 * h + j] - im[i3] * w_im[2 * h + j];
+            const double t3_im = re[i3] * w_im[2 * h + j] + im[i3] * w_re[2 * h + j];
+
+            const double s0_re = re[i0] + t1_re, s0_im = im[i0] + t1_im;
+            const double d0_re = re[i0] - t1_re, d0_im = im[i0] - t1_im;
+            const double s1_re = t2_re + t3_re, s1_im = t2_im + t3_im;
+            const double d1_re = t2_re - t3_re, d1_im = t2_im - t3_im;
+            const double p_re = d0_re + d1_im, p_im = d0_im - d1_re;
+            const double m_re = d0_re - d1_im, m_im = d0_im + d1_re;
+
+            re[i0] = s0_re + s1_re;
+            im[i0] = s0_im + s1_im;
+            re[i2] = s0_re - s1_re;
+            im[i2] = s0_im - s1_im;
+            re[i1] = inverse ? m_re : p_re;
+            im[i1] = inverse ? m_im : p_im;
+            re[i3] = inverse ? p_re : m_re;
+            im[i3] = inverse ? p_im : m_im;
+        }
+    }
+}
+
+static void fft_plan_stages_split(const struct FFTPlan* plan, double* re, double* im) {
+    const int N = plan->N;
+    const double* w_re = plan->stage_twiddles_split;
+    const double* w_im = plan->stage_twiddles_split + N;
+    if (plan->algorithm == PLAN_RADIX_4) {
+        int h = 1;
+        if (N > 1 && (N & 0x55555555) == 0) {
+            radix_2_stage_split(re, im, N, 1, w_re, w_im);
+            w_re += 1;
+            w_im += 1;
+            h = 2;
+        }
+        for (; 4 * h <= N; h *= 4) {
+            radix_4_stage_split(re, im, N, h, w_re, w_im, plan->inverse);
+            w_re += 3 * h;
+            w_im += 3 * h;
+        }
+    } else {
+        for (int half = 1; half < N; half <<= 1) {
+            radix_2_stage_split(re, im, N, half, w_re, w_im);
+            w_re += half;
+            w_im += half;
+        }
+    }
+
+    if (plan->inverse) {
+        const double scale = 1.0 / N;
+        for (int i = 0; i < N; i++) {
+            re[i] *= scale;
+            im[i] *= scale;
+        }
+    }
+}
+
+int fft_plan_split_work_size(const struct FFTPlan* plan) {
+    if (plan->bit_rev != NULL) {
+        return 0;
+    }
+    return plan->N + fft_plan_work_size(plan);
+}
+
+void fft_plan_execute_split(const struct FFTPlan* plan, const double* re_in, const double* im_in, double* re_out,
+                            double* im_out, struct Complex* work) {
+    const int N = plan->N;
+    if (plan->bit_rev == NULL) {
+        for (int i = 0; i < N; i++) {
+            work[i] = (struct Complex){re_in[i], im_in != NULL ? im_in[i] : 0};
+        }
+        fft_plan_execute_work(plan, work, work, work + N);
+        for (int i = 0; i < N; i++) {
+            re_out[i] = work[i].real;
+            im_out[i] = work[i].imag;
+        }
+        return;
+    }
+
+    if (re_in != re_out && (im_in == NULL || im_in != im_out)) {
+        for (int i = 0; i < N; i++) {
+            re_out[i] = re_in[plan->bit_rev[i]];
+            im_out[i] = im_in != NULL ? im_in[plan->bit_rev[i]] : 0;
+        }
+    } else {
+        if (re_in != re_out) {
+            memcpy(re_out, re_in, N * sizeof(double));
+        }
+        if (im_in == NULL) {
+            memset(im_out, 0, N * sizeof(double));
+        } else if (im_in != im_out) {
+            memcpy(im_out, im_in, N * sizeof(double));
+        }
+        for (int i = 0; i < N; i++) {
+            const int j = plan->bit_rev[i];
+            if (i < j) {
+                const double temp_re = re_out[i];
+                const double temp_im = im_out[i];
+                re_out[i] = re_out[j];
+                im_out[i] = im_out[j];
+                re_out[j] = temp_re;
+                im_out[j] = temp_im;
+            }
+        }
+    }
+    fft_plan_stages_split(plan, re_out, im_out);
+}
+
+static int pow_mod(long long base, int e, const int mod) {
+    long long result = 1;
+    base %= mod;
+    while (e > 0) {
+        if (e & 1) {
+            result = result * base % mod;
+        }
+        base = base * base % mod;
+        e >>= 1;
+    }
+    return (int) result;
+}
+
+/* Smallest generator of the multiplicative group modulo the prime N. */
+static int primitive_root(const int N) {
+    int prime_factors[32];
+    int n_prime_factors = 0;
+    int rest = N - 1;
+    for (int p = 2; p * p <= rest; p++) {
+        if (rest % p == 0) {
+            prime_factors[n_prime_factors++] = p;
+            while (rest % p == 0) {
+                rest /= p;
+            }
+        }
+    }
+    if (rest > 1) {
+        prime_factors[n_prime_factors++] = rest;
+    }
+
+    for (int g = 2; g < N; g++) {
+        int is_generator = 1;
+        for (int i = 0; i < n_prime_factors && is_generator; i++) {
+            is_generator = pow_mod(g, (N - 1) / prime_factors[i], N) != 1;
+        }
+        if (is_generator) {
+            return g;
+        }
+    }
+    return 1;
+}
+
+struct RaderPlan* rader_plan_create(const int N, const int inverse) {
+    if (N < 3 || largest_prime_factor(N) != N) {
+        fprintf(stderr, "rader_plan_create: N=%d is not an odd prime\n", N);
+        return NULL;
+    }
+
+    struct RaderPlan* plan = calloc(1, sizeof(struct RaderPlan));
+    if (plan == NULL) {
+        fprintf(stderr, "rader_plan_create failed\n");
+        return NULL;
+    }
+    const int L = N - 1;
+    plan->N = N;
+    plan->inverse = inverse;
+    plan->input_index = malloc(L * sizeof(int));
+    plan->output_index = malloc(L * sizeof(int));
+    plan->forward = fft_plan_create(L, 0);
+    plan->backward = fft_plan_create(L, 1);
+    struct Complex* b = malloc_cplx_arr(L);
+    if (plan->input_index == NULL || plan->output_index == NULL || plan->forward == NULL
+        || plan->backward == NULL || b == NULL) {
+        fft_free(b);
+        rader_plan_destroy(plan);
+        return NULL;
+    }
+
+    const int g = primitive_root(N);
+    const int g_inv = pow_mod(g, N - 2, N);
+    int g_q = 1;
+    int g_inv_q = 1;
+    for (int q = 0; q < L; q++) {
+        plan->input_index[q] = g_q;
+        plan->output_index[q] = g_inv_q;
+        g_q = (int) ((long long) g_q * g % N);
+        g_inv_q = (int) ((long long) g_inv_q * g_inv % N);
+    }
+
+    /* X[g^-p] = x[0] + sum_q x[g^q] * W^(g^(q-p)), a cyclic convolution with b[m] = W^(g^-m). */
+    const double factor = inverse ? 2.0 : -2.0;
+    for (int q = 0; q < L; q++) {
+        b[q] = exp_q(factor * M_PI * plan->output_index[q] / N);
+    }
+    plan->B = fft_plan_execute(plan->forward, b);
+    fft_free(b);
+    if (plan->B == NULL) {
+        rader_plan_destroy(plan);
+        return NULL;
+    }
+    return plan;
+}
+
+int rader_plan_work_size(const struct RaderPlan* plan) {
+    const int forward_work = fft_plan_work_size(plan->forward);
+    const int backward_work = fft_plan_work_size(plan->backward);
+    return plan->N - 1 + (forward_work > backward_work ? forward_work : backward_work);
+}
+
+void rader_plan_execute_into(const struct RaderPlan* plan, const struct Complex* x, struct Complex* X,
+                             struct Complex* work) {
+    const int N = plan->N;
+    const int L = N - 1;
+    struct Complex* sub_work = work + L;
+
+    const struct Complex x0 = x[0];
+    struct Complex sum = x0;
+    for (int q = 0; q < L; q++) {
+        work[q] = x[plan->input_index[q]];
+        sum = cadd(sum, work[q]);
+    }
+
+    fft_plan_execute_work(plan->forward, work, work, sub_work);
+    for (int q = 0; q < L; q++) {
+        work[q] = cmul(work[q], plan->B[q]);
+    }
+    fft_plan_execute_work(plan->backward, work, work, sub_work);
+
+    const double scale = plan->inverse ? 1.0 / N : 1.0;
+    X[0] = (struct Complex){sum.real * scale, sum.imag * scale};
+    for (int p = 0; p < L; p++) {
+        const struct Complex value = cadd(x0, work[p]);
+        X[plan->output_index[p]] = (struct Complex){value.real * scale, value.imag * scale};
+    }
+}
+
+void rader_plan_destroy(struct RaderPlan* plan) {
+    if (plan == NULL) {
+        return;
+    }
+    free(plan->input_index);
+    free(plan->output_index);
+    fft_free(plan->B);
+    fft_plan_destroy(plan->forward);
+    fft_plan_destroy(plan->backward);
+    free(plan);
+}
+
+struct BluesteinPlan* bluestein_plan_create(const int N, const int inverse) {
+    if (N < 1) {
+        fprintf(stderr, "bluestein_plan_create: invalid N=%d\n", N);
+        return NULL;
+    }
+
+    struct BluesteinPlan* plan = calloc(1, sizeof(struct BluesteinPlan));
+    if (plan == NULL) {
+        fprintf(stderr, "bluestein_plan_create failed\n");
+        return NULL;
+    }
+    const int M = next_power_of_two(2 * N - 1);
+    plan->N = N;
+    plan->M = M;
+    plan->inverse = inverse;
+    plan->chirp = malloc_cplx_arr(N);
+    plan->forward = fft_plan_create(M, 0);
+    plan->backward = fft_plan_create(M, 1);
+    struct Complex* b = calloc_cplx_arr(M);
+    if (plan->chirp == NULL || plan->forward == NULL || plan->backward == NULL || b == NULL) {
+        fft_free(b);
+        bluestein_plan_destroy(plan);
+        return NULL;
+    }
+
+    const double factor = inverse ? 1.0 : -1.0;
+    for (int k = 0; k < N; k++) {
+        const double theta = factor * M_PI * (double) ((long long) k * k % (2LL * N)) / N;
+        plan->chirp[k] = exp_q(theta);
+    }
+
+    b[0] = conj_q(plan->chirp[0]);
+    for (int k = 1; k < N; k++) {
+        b[k] = conj_q(plan->chirp[k]);
+        b[M - k] = conj_q(plan->chirp[k]);
+    }
+    plan->B = fft_plan_execute(plan->forward, b);
+    fft_free(b);
+    if (plan->B == NULL) {
+        bluestein_plan_destroy(plan);
+        return NULL;
+    }
+    return plan;
+}
+
+struct Complex* bluestein_plan_execute(const struct BluesteinPlan* plan, const struct Complex* x) {
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct Complex* X = malloc_cplx_arr(plan->N);
+    struct Complex* work = fft_arena_cplx_arr(arena, plan->M);
+    if (X != NULL && work != NULL) {
+        bluestein_plan_execute_into(plan, x, X, work);
+    } else {
+        fft_free(X);
+        X = NULL;
+    }
+    fft_arena_release(arena, mark);
+    return X;
+}
+
+void bluestein_plan_execute_into(const struct BluesteinPlan* plan, const struct Complex* x, struct Complex* X,
+                                 struct Complex* work) {
+    const int N = plan->N;
+    const int M = plan->M;
+
+    for (int k = 0; k < N; k++) {
+        work[k] = cmul(x[k], plan->chirp[k]);
+    }
+    for (int k = N; k < M; k++) {
+        work[k] = (struct Complex){0, 0};
+    }
+
+    fft_plan_execute_inplace(plan->forward, work);
+    for (int k = 0; k < M; k++) {
+        work[k] = cmul(work[k], plan->B[k]);
+    }
+    fft_plan_execute_inplace(plan->backward, work);
+
+    const double scale = plan->inverse ? 1.0 / N : 1.0;
+    for (int k = 0; k < N; k++) {
+        X[k] = cmul(work[k], plan->chirp[k]);
+        X[k].real *= scale;
+        X[k].imag *= scale;
+    }
+}
+
+void bluestein_plan_destroy(struct BluesteinPlan* plan) {
+    if (plan == NULL) {
+        return;
+    }
+    fft_free(plan->chirp);
+    fft_free(plan->B);
+    fft_plan_destroy(plan->forward);
+    fft_plan_destroy(plan->backward);
+    free(plan);
+}
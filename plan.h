@@ -0,0 +1,132 @@
+#ifndef PLAN_H
+#define PLAN_H
+#include "complex.h"
+
+#define MAX_FACTORS 32
+
+enum PlanAlgorithm {
+    PLAN_RADIX_2,       /* power-of-two lengths */
+    PLAN_RADIX_4,       /* power-of-two lengths, one radix-2 stage when log2(N) is odd */
+    PLAN_MIXED_RADIX,   /* lengths whose prime factors are all <= 7 */
+    PLAN_RADER,         /* prime lengths, as a cyclic convolution of length N - 1 */
+    PLAN_BLUESTEIN,     /* any length */
+    PLAN_STOCKHAM       /* 7-smooth lengths, autosort: ping-pongs with a work buffer instead of permuting */
+};
+
+/* FFT PLAN */
+struct FFTPlan {
+    int N;
+    int inverse;
+    enum PlanAlgorithm algorithm;
+    int* bit_rev;               /* power-of-two plans: bit-reversal permutation, N entries */
+    int factors[2 * MAX_FACTORS];  /* mixed radix: (radix, remaining length) pairs */
+    int n_factors;
+    struct Complex* twiddles;   /* exp(-+2*pi*i*k/N); k < N/2 (radix 2), 3N/4 (radix 4), N (mixed radix) */
+    struct Complex* stage_twiddles; /* power-of-two plans: each stage's twiddles in order, contiguous for the SIMD kernels */
+    double* stage_twiddles_split;   /* the same N entries as N real parts followed by N imaginary parts */
+    struct RaderPlan* rader;
+    struct BluesteinPlan* bluestein;
+};
+
+/*
+ * Picks radix 4 for powers of two, mixed radix for 7-smooth lengths, Rader for
+ * primes N with a 7-smooth N - 1 where its estimated cost is below Bluestein's
+ * (always when N - 1 is a power of two), and Bluestein otherwise.
+ */
+struct FFTPlan* fft_plan_create(int N, int inverse);
+
+struct FFTPlan* fft_plan_create_algorithm(int N, int inverse, enum PlanAlgorithm algorithm);
+
+struct FFTPlan* fft_plan_create_radix(int N, int inverse, int radix);
+
+/* Mixed-radix plan with an explicit radix order (each of 2, 3, 4, 5, 7; the product must be N). */
+struct FFTPlan* fft_plan_create_mixed_radix(int N, int inverse, const int* radices, int n_radices);
+
+const char* plan_algorithm_name(enum PlanAlgorithm algorithm);
+
+struct Complex* fft_plan_execute(const struct FFTPlan* plan, const struct Complex* x);
+
+void fft_plan_execute_inplace(const struct FFTPlan* plan, struct Complex* x);
+
+/* x and X must not overlap. */
+void fft_plan_execute_into(const struct FFTPlan* plan, const struct Complex* x, struct Complex* X);
+
+/*
+ * For convolutions, where the spectrum is only multiplied pointwise: a
+ * forward plan leaves X in a scrambled order and an inverse plan takes that
+ * order back to natural output, so neither pays for a permutation. The order
+ * is bit-reversed for radix-2 / radix-4 plans and natural for the others, so
+ * a forward and an inverse plan only compose when fft_plan_scrambled_order
+ * agrees for both; plans from fft_plan_get are chosen per direction and may
+ * not. x and X may be the same buffer.
+ */
+void fft_plan_execute_scrambled(const struct FFTPlan* plan, const struct Complex* x, struct Complex* X);
+
+/* 1 if fft_plan_execute_scrambled works in bit-reversed order, 0 if in natural order. */
+int fft_plan_scrambled_order(const struct FFTPlan* plan);
+
+/* Work buffer length (in elements) needed by fft_plan_execute_work. */
+int fft_plan_work_size(const struct FFTPlan* plan);
+
+/* Never allocates; x and X may be the same buffer. */
+void fft_plan_execute_work(const struct FFTPlan* plan, const struct Complex* x, struct Complex* X,
+                           struct Complex* work);
+
+void fft_plan_destroy(struct FFTPlan* plan);
+
+/*
+ * SPLIT-COMPLEX EXECUTION
+ * Real and imaginary parts in separate arrays. Power-of-two plans run their
+ * stages on the split arrays directly, with no shuffles in the complex
+ * multiplies; other plans interleave through the work buffer.
+ */
+/* Work buffer length for fft_plan_execute_split; 0 for power-of-two plans. */
+int fft_plan_split_work_size(const struct FFTPlan* plan);
+
+/* im_in may be NULL for real input; the outputs may be the inputs. Never allocates. */
+void fft_plan_execute_split(const struct FFTPlan* plan, const double* re_in, const double* im_in, double* re_out,
+                            double* im_out, struct Complex* work);
+
+/* RADER PLAN */
+struct RaderPlan {
+    int N;                      /* prime */
+    int inverse;
+    int* input_index;           /* g^q mod N, N - 1 entries */
+    int* output_index;          /* g^-q mod N, N - 1 entries */
+    struct Complex* B;          /* FFT of exp(-+2*pi*i*g^-q/N), N - 1 entries */
+    struct FFTPlan* forward;    /* length N - 1 */
+    struct FFTPlan* backward;
+};
+
+struct RaderPlan* rader_plan_create(int N, int inverse);
+
+/* work must hold rader_plan_work_size(plan) elements; x and X may be the same buffer. */
+int rader_plan_work_size(const struct RaderPlan* plan);
+
+void rader_plan_execute_into(const struct RaderPlan* plan, const struct Complex* x, struct Complex* X,
+                             struct Complex* work);
+
+void rader_plan_destroy(struct RaderPlan* plan);
+
+/* BLUESTEIN PLAN */
+struct BluesteinPlan {
+    int N;
+    int M;                      /* power-of-two convolution length, >= 2N - 1 */
+    int inverse;
+    struct Complex* chirp;      /* exp(-+i*pi*k^2/N), N entries */
+    struct Complex* B;          /* FFT of the conjugate chirp kernel, M entries */
+    struct FFTPlan* forward;
+    struct FFTPlan* backward;
+};
+
+struct BluesteinPlan* bluestein_plan_create(int N, int inverse);
+
+struct Complex* bluestein_plan_execute(const struct BluesteinPlan* plan, const struct Complex* x);
+
+/* work must hold plan->M elements; x and X may be the same buffer. */
+void bluestein_plan_execute_into(const struct BluesteinPlan* plan, const struct Complex* x, struct Complex* X,
+                                 struct Complex* work);
+
+void bluestein_plan_destroy(struct BluesteinPlan* plan);
+
+#endif //PLAN_H
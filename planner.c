@@ -0,0 +1,650 @@
+#include "planner.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#endif
+
+#include "arena.h"
+#include "complex.h"
+#include "fft.h"
+#include "fftf.h"
+#include "plan.h"
+#include "rfft.h"
+#include "threads.h"
+#include "util.h"
+
+/* Minimum timed duration per candidate, so short transforms are measured over many runs. */
+const double MEASURE_MIN_SECONDS = 0.01;
+
+static enum PlannerMode planner_mode = PLANNER_ESTIMATE;
+
+void fft_planner_set_mode(const enum PlannerMode mode) {
+    planner_mode = mode;
+}
+
+enum PlannerMode fft_planner_get_mode(void) {
+    return planner_mode;
+}
+
+/* An engine choice for one length: what the planner measures and what wisdom records. */
+struct PlanChoice {
+    enum PlanAlgorithm algorithm;
+    int radices[MAX_FACTORS];   /* mixed radix only */
+    int n_radices;
+};
+
+static struct FFTPlan* plan_from_choice(const int N, const int inverse, const struct PlanChoice* choice) {
+    if (choice->algorithm == PLAN_MIXED_RADIX && choice->n_radices > 0) {
+        return fft_plan_create_mixed_radix(N, inverse, choice->radices, choice->n_radices);
+    }
+    return fft_plan_create_algorithm(N, inverse, choice->algorithm);
+}
+
+static void choice_from_plan(const struct FFTPlan* plan, struct PlanChoice* choice) {
+    choice->algorithm = plan->algorithm;
+    choice->n_radices = 0;
+    if (plan->algorithm == PLAN_MIXED_RADIX) {
+        for (int i = 0; i < plan->n_factors; i++) {
+            choice->radices[i] = plan->factors[2 * i];
+        }
+        choice->n_radices = plan->n_factors;
+    }
+}
+
+static int candidate_choices(const int N, struct PlanChoice* choices) {
+    int count = 0;
+    if ((N & (N - 1)) == 0) {
+        choices[count++] = (struct PlanChoice){PLAN_RADIX_2, {0}, 0};
+        choices[count++] = (struct PlanChoice){PLAN_RADIX_4, {0}, 0};
+    }
+    if (largest_prime_factor(N) <= 7) {
+        /* default order (radix 4 first, small to large), and the same radices largest first */
+        struct FFTPlan* plan = fft_plan_create_algorithm(N, 0, PLAN_MIXED_RADIX);
+        if (plan != NULL) {
+            struct PlanChoice forward_order;
+            choice_from_plan(plan, &forward_order);
+            choices[count++] = forward_order;
+
+            struct PlanChoice reverse_order = forward_order;
+            for (int i = 0; i < forward_order.n_radices; i++) {
+                reverse_order.radices[i] = forward_order.radices[forward_order.n_radices - 1 - i];
+            }
+            if (forward_order.n_radices > 1 && forward_order.radices[0] != reverse_order.radices[0]) {
+                choices[count++] = reverse_order;
+            }
+            fft_plan_destroy(plan);
+        }
+        choices[count++] = (struct PlanChoice){PLAN_STOCKHAM, {0}, 0};
+    }
+    if (N > 2 && largest_prime_factor(N) == N) {
+        choices[count++] = (struct PlanChoice){PLAN_RADER, {0}, 0};
+    }
+    if ((N & (N - 1)) != 0) {
+        choices[count++] = (struct PlanChoice){PLAN_BLUESTEIN, {0}, 0};
+    }
+    return count;
+}
+
+static double seconds_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double) now.tv_sec + (double) now.tv_nsec * 1e-9;
+}
+
+/* Wall-clock seconds per transform, averaged over enough runs to cover MEASURE_MIN_SECONDS. */
+static double time_plan(const struct FFTPlan* plan, const struct Complex* x, struct Complex* X,
+                        struct Complex* work) {
+    long runs = 1;
+    while (1) {
+        const double start = seconds_now();
+        for (long i = 0; i < runs; i++) {
+            fft_plan_execute_work(plan, x, X, work);
+        }
+        const double elapsed = seconds_now() - start;
+        if (elapsed >= MEASURE_MIN_SECONDS || runs >= 1L << 20) {
+            return elapsed / runs;
+        }
+        runs *= 2;
+    }
+}
+
+struct FFTPlan* fft_plan_measure(const int N, const int inverse) {
+    if (N < 1) {
+        fprintf(stderr, "fft_plan_measure: invalid N=%d\n", N);
+        return NULL;
+    }
+
+    struct PlanChoice choices[8];
+    const int n_choices = candidate_choices(N, choices);
+
+    struct Complex* x = malloc_cplx_arr(N);
+    struct Complex* X = malloc_cplx_arr(N);
+    if (x == NULL || X == NULL) {
+        fft_free(x);
+        fft_free(X);
+        return NULL;
+    }
+    /* A fixed pseudo-random input: measuring must not touch the caller's rand() sequence. */
+    unsigned int state = 12345;
+    for (int i = 0; i < N; i++) {
+        state = state * 1103515245u + 12345u;
+        const double re = (double) (state >> 8) / (1u << 24) - 0.5;
+        state = state * 1103515245u + 12345u;
+        const double im = (double) (state >> 8) / (1u << 24) - 0.5;
+        x[i] = (struct Complex){re, im};
+    }
+
+    struct FFTPlan* best = NULL;
+    double best_time = 0;
+    for (int i = 0; i < n_choices; i++) {
+        struct FFTPlan* candidate = plan_from_choice(N, inverse, &choices[i]);
+        if (candidate == NULL) {
+            continue;
+        }
+        struct Complex* work = malloc_cplx_arr(fft_plan_work_size(candidate) + 1);
+        if (work == NULL) {
+            fft_plan_destroy(candidate);
+            continue;
+        }
+        const double elapsed = time_plan(candidate, x, X, work);
+        fft_free(work);
+
+        if (best == NULL || elapsed < best_time) {
+            fft_plan_destroy(best);
+            best = candidate;
+            best_time = elapsed;
+        } else {
+            fft_plan_destroy(candidate);
+        }
+    }
+
+    fft_free(x);
+    fft_free(X);
+    return best;
+}
+
+/* WISDOM */
+const int WISDOM_VERSION = 1;
+
+struct WisdomEntry {
+    int N;
+    int inverse;
+    struct PlanChoice choice;
+    struct WisdomEntry* next;
+};
+
+/* Guards the plan cache, the wisdom list and the lazy wisdom import. */
+static pthread_mutex_t planner_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static struct WisdomEntry* wisdom = NULL;
+static int wisdom_env_loaded = 0;
+
+static struct WisdomEntry* wisdom_find(const int N, const int inverse) {
+    for (struct WisdomEntry* e = wisdom; e != NULL; e = e->next) {
+        if (e->N == N && e->inverse == inverse) {
+            return e;
+        }
+    }
+    return NULL;
+}
+
+static void wisdom_remember(const int N, const int inverse, const struct PlanChoice* choice) {
+    struct WisdomEntry* entry = wisdom_find(N, inverse);
+    if (entry == NULL) {
+        entry = malloc(sizeof(struct WisdomEntry));
+        if (entry == NULL) {
+            fprintf(stderr, "wisdom_remember failed\n");
+            return;
+        }
+        entry->N = N;
+        entry->inverse = inverse;
+        entry->next = wisdom;
+        wisdom = entry;
+    }
+    entry->choice = *choice;
+}
+
+/* Vendor, family, model and stepping; wisdom measured on another CPU is ignored. */
+static void cpu_signature(char* signature, const size_t size) {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(0, &eax, &ebx, &ecx, &edx)) {
+        char vendor[13];
+        memcpy(vendor, &ebx, 4);
+        memcpy(vendor + 4, &edx, 4);
+        memcpy(vendor + 8, &ecx, 4);
+        vendor[12] = '\0';
+        __get_cpuid(1, &eax, &ebx, &ecx, &edx);
+        const unsigned int family = (eax >> 8 & 0xf) + (eax >> 20 & 0xff);
+        const unsigned int model = (eax >> 4 & 0xf) | (eax >> 12 & 0xf0);
+        snprintf(signature, size, "%s-%u-%u-%u", vendor, family, model, eax & 0xf);
+        return;
+    }
+#endif
+    snprintf(signature, size, "generic");
+}
+
+static int parse_algorithm(const char* name, enum PlanAlgorithm* algorithm) {
+    const enum PlanAlgorithm all[] = {
+        PLAN_RADIX_2, PLAN_RADIX_4, PLAN_MIXED_RADIX, PLAN_RADER, PLAN_BLUESTEIN, PLAN_STOCKHAM
+    };
+    for (size_t i = 0; i < sizeof(all) / sizeof(all[0]); i++) {
+        if (strcmp(name, plan_algorithm_name(all[i])) == 0) {
+            *algorithm = all[i];
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* Radices written as "4x4x3"; "-" for none. */
+static int parse_radices(const char* text, struct PlanChoice* choice) {
+    choice->n_radices = 0;
+    if (strcmp(text, "-") == 0) {
+        return 1;
+    }
+    const char* p = text;
+    while (*p != '\0') {
+        char* end;
+        const long radix = strtol(p, &end, 10);
+        if (end == p || choice->n_radices == MAX_FACTORS) {
+            return 0;
+        }
+        choice->radices[choice->n_radices++] = (int) radix;
+        p = *end == 'x' ? end + 1 : end;
+        if (*end != 'x' && *end != '\0') {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void wisdom_write_locked(FILE* file) {
+    char signature[64];
+    cpu_signature(signature, sizeof(signature));
+    fprintf(file, "fft-c-wisdom %d\ncpu %s\n", WISDOM_VERSION, signature);
+
+    for (const struct WisdomEntry* e = wisdom; e != NULL; e = e->next) {
+        fprintf(file, "%d %d %s ", e->N, e->inverse, plan_algorithm_name(e->choice.algorithm));
+        if (e->choice.n_radices == 0) {
+            fprintf(file, "-");
+        }
+        for (int i = 0; i < e->choice.n_radices; i++) {
+            fprintf(file, i == 0 ? "%d" : "x%d", e->choice.radices[i]);
+        }
+        fprintf(file, "\n");
+    }
+}
+
+static int wisdom_read_locked(FILE* file) {
+    char line[256];
+    int version = 0;
+    char file_signature[64] = "";
+    if (fgets(line, sizeof(line), file) == NULL || sscanf(line, "fft-c-wisdom %d", &version) != 1
+        || version != WISDOM_VERSION) {
+        fprintf(stderr, "fft_wisdom_import: not version %d wisdom\n", WISDOM_VERSION);
+        return -1;
+    }
+    char signature[64];
+    cpu_signature(signature, sizeof(signature));
+    if (fgets(line, sizeof(line), file) == NULL || sscanf(line, "cpu %63s", file_signature) != 1
+        || strcmp(file_signature, signature) != 0) {
+        /* Measured on another machine: the choices would not be the fastest here. */
+        return 0;
+    }
+
+    /* Malformed or inapplicable lines are skipped; those lengths are simply planned again. */
+    while (fgets(line, sizeof(line), file) != NULL) {
+        int N, inverse;
+        char name[32], radices[160];
+        struct PlanChoice choice;
+        if (sscanf(line, "%d %d %31s %159s", &N, &inverse, name, radices) != 4 || N < 1
+            || !parse_algorithm(name, &choice.algorithm) || !parse_radices(radices, &choice)) {
+            continue;
+        }
+        wisdom_remember(N, inverse != 0, &choice);
+    }
+    return 0;
+}
+
+/* The FFT_C_WISDOM file, read once before the first plan or explicit wisdom call. */
+static void wisdom_env_load_locked(void) {
+    if (wisdom_env_loaded) {
+        return;
+    }
+    wisdom_env_loaded = 1;
+    const char* filename = getenv(WISDOM_ENV);
+    FILE* file = filename != NULL ? fopen(filename, "r") : NULL;
+    if (file != NULL) {
+        wisdom_read_locked(file);
+        fclose(file);
+    }
+}
+
+int fft_wisdom_export_file(FILE* file) {
+    pthread_mutex_lock(&planner_lock);
+    wisdom_env_load_locked();
+    wisdom_write_locked(file);
+    pthread_mutex_unlock(&planner_lock);
+    return ferror(file) ? -1 : 0;
+}
+
+int fft_wisdom_export(const char* filename) {
+    FILE* file = fopen(filename, "w");
+    if (file == NULL) {
+        fprintf(stderr, "fft_wisdom_export: cannot open %s\n", filename);
+        return -1;
+    }
+    const int result = fft_wisdom_export_file(file);
+    return fclose(file) == 0 ? result : -1;
+}
+
+int fft_wisdom_import_file(FILE* file) {
+    pthread_mutex_lock(&planner_lock);
+    wisdom_env_load_locked();
+    const int result = wisdom_read_locked(file);
+    pthread_mutex_unlock(&planner_lock);
+    return result;
+}
+
+int fft_wisdom_import(const char* filename) {
+    FILE* file = fopen(filename, "r");
+    if (file == NULL) {
+        fprintf(stderr, "fft_wisdom_import: cannot open %s\n", filename);
+        return -1;
+    }
+    const int result = fft_wisdom_import_file(file);
+    fclose(file);
+    return result;
+}
+
+void fft_wisdom_forget(void) {
+    pthread_mutex_lock(&planner_lock);
+    wisdom_env_loaded = 1;
+    while (wisdom != NULL) {
+        struct WisdomEntry* next = wisdom->next;
+        free(wisdom);
+        wisdom = next;
+    }
+    pthread_mutex_unlock(&planner_lock);
+}
+
+/* Plans a length from wisdom, or NULL if it has none. Called with planner_lock held. */
+static struct FFTPlan* planner_wisdom_plan_locked(const int N, const int inverse) {
+    wisdom_env_load_locked();
+    const struct WisdomEntry* entry = wisdom_find(N, inverse);
+    return entry != NULL ? plan_from_choice(N, inverse, &entry->choice) : NULL;
+}
+
+/*
+ * Plans a length from wisdom if present, otherwise by the current planner mode.
+ * Measuring takes milliseconds per candidate, so it runs without planner_lock;
+ * other threads keep getting their cached plans meanwhile.
+ */
+struct FFTPlan* fft_planner_create(const int N, const int inverse) {
+    pthread_mutex_lock(&planner_lock);
+    struct FFTPlan* plan = planner_wisdom_plan_locked(N, inverse);
+    pthread_mutex_unlock(&planner_lock);
+    if (plan != NULL) {
+        return plan;
+    }
+
+    if (planner_mode == PLANNER_MEASURE) {
+        plan = fft_plan_measure(N, inverse);
+        if (plan != NULL) {
+            struct PlanChoice choice;
+            choice_from_plan(plan, &choice);
+            pthread_mutex_lock(&planner_lock);
+            wisdom_remember(N, inverse, &choice);
+            pthread_mutex_unlock(&planner_lock);
+        }
+        return plan;
+    }
+    return fft_plan_create(N, inverse);
+}
+
+struct PlanCacheEntry {
+    struct FFTPlan* plan;
+    struct PlanCacheEntry* next;
+};
+
+static struct PlanCacheEntry* plan_cache = NULL;
+
+static const struct FFTPlan* plan_find_locked(const int N, const int inverse) {
+    for (const struct PlanCacheEntry* e = plan_cache; e != NULL; e = e->next) {
+        if (e->plan->N == N && e->plan->inverse == inverse) {
+            return e->plan;
+        }
+    }
+    return NULL;
+}
+
+/* The plan is built unlocked, as it may be measured, and the cache checked again before inserting. */
+const struct FFTPlan* fft_plan_get(const int N, const int inverse) {
+    pthread_mutex_lock(&planner_lock);
+    const struct FFTPlan* cached = plan_find_locked(N, inverse);
+    pthread_mutex_unlock(&planner_lock);
+    if (cached != NULL) {
+        return cached;
+    }
+
+    struct FFTPlan* plan = fft_planner_create(N, inverse);
+    struct PlanCacheEntry* entry = malloc(sizeof(struct PlanCacheEntry));
+    if (plan == NULL || entry == NULL) {
+        fprintf(stderr, "fft_plan_get failed\n");
+        fft_plan_destroy(plan);
+        free(entry);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&planner_lock);
+    cached = plan_find_locked(N, inverse);
+    if (cached == NULL) {
+        entry->plan = plan;
+        entry->next = plan_cache;
+        plan_cache = entry;
+        cached = plan;
+        plan = NULL;
+        entry = NULL;
+    }
+    pthread_mutex_unlock(&planner_lock);
+    fft_plan_destroy(plan);
+    free(entry);
+    return cached;
+}
+
+static struct PlanCacheEntry* algorithm_plan_cache = NULL;
+
+/* fft_plan_create_algorithm never enters the planner, so the plan is built under the lock. */
+const struct FFTPlan* fft_plan_get_algorithm(const int N, const int inverse, const enum PlanAlgorithm algorithm) {
+    pthread_mutex_lock(&planner_lock);
+    for (const struct PlanCacheEntry* e = algorithm_plan_cache; e != NULL; e = e->next) {
+        if (e->plan->N == N && e->plan->inverse == inverse && e->plan->algorithm == algorithm) {
+            pthread_mutex_unlock(&planner_lock);
+            return e->plan;
+        }
+    }
+
+    struct PlanCacheEntry* entry = malloc(sizeof(struct PlanCacheEntry));
+    if (entry == NULL) {
+        fprintf(stderr, "fft_plan_get_algorithm failed\n");
+        pthread_mutex_unlock(&planner_lock);
+        return NULL;
+    }
+    entry->plan = fft_plan_create_algorithm(N, inverse, algorithm);
+    if (entry->plan == NULL) {
+        free(entry);
+        pthread_mutex_unlock(&planner_lock);
+        return NULL;
+    }
+    entry->next = algorithm_plan_cache;
+    algorithm_plan_cache = entry;
+    pthread_mutex_unlock(&planner_lock);
+    return entry->plan;
+}
+
+struct RealPlanCacheEntry {
+    struct RealFFTPlan* plan;
+    struct RealPlanCacheEntry* next;
+};
+
+static struct RealPlanCacheEntry* real_plan_cache = NULL;
+
+static const struct RealFFTPlan* real_plan_find_locked(const int N, const int inverse) {
+    for (const struct RealPlanCacheEntry* e = real_plan_cache; e != NULL; e = e->next) {
+        if (e->plan->N == N && e->plan->inverse == inverse) {
+            return e->plan;
+        }
+    }
+    return NULL;
+}
+
+/* rfft_plan_create plans its complex half through the planner, so this builds unlocked as fft_plan_get does. */
+const struct RealFFTPlan* rfft_plan_get(const int N, const int inverse) {
+    pthread_mutex_lock(&planner_lock);
+    const struct RealFFTPlan* cached = real_plan_find_locked(N, inverse);
+    pthread_mutex_unlock(&planner_lock);
+    if (cached != NULL) {
+        return cached;
+    }
+
+    struct RealFFTPlan* plan = rfft_plan_create(N, inverse);
+    struct RealPlanCacheEntry* entry = malloc(sizeof(struct RealPlanCacheEntry));
+    if (plan == NULL || entry == NULL) {
+        fprintf(stderr, "rfft_plan_get failed\n");
+        rfft_plan_destroy(plan);
+        free(entry);
+        return NULL;
+    }
+
+    pthread_mutex_lock(&planner_lock);
+    cached = real_plan_find_locked(N, inverse);
+    if (cached == NULL) {
+        entry->plan = plan;
+        entry->next = real_plan_cache;
+        real_plan_cache = entry;
+        cached = plan;
+        plan = NULL;
+        entry = NULL;
+    }
+    pthread_mutex_unlock(&planner_lock);
+    rfft_plan_destroy(plan);
+    free(entry);
+    return cached;
+}
+
+struct PlanFCacheEntry {
+    struct FFTPlanF* plan;
+    struct PlanFCacheEntry* next;
+};
+
+static struct PlanFCacheEntry* planf_cache = NULL;
+
+/* fft_planf_create never enters the planner, so the plan is built under the lock as in fft_plan_get. */
+const struct FFTPlanF* fft_planf_get(const int N, const int inverse) {
+    pthread_mutex_lock(&planner_lock);
+    for (const struct PlanFCacheEntry* e = planf_cache; e != NULL; e = e->next) {
+        if (e->plan->N == N && e->plan->inverse == inverse) {
+            pthread_mutex_unlock(&planner_lock);
+            return e->plan;
+        }
+    }
+
+    struct PlanFCacheEntry* entry = malloc(sizeof(struct PlanFCacheEntry));
+    if (entry == NULL) {
+        fprintf(stderr, "fft_planf_get failed\n");
+        pthread_mutex_unlock(&planner_lock);
+        return NULL;
+    }
+    entry->plan = fft_planf_create(N, inverse);
+    if (entry->plan == NULL) {
+        free(entry);
+        pthread_mutex_unlock(&planner_lock);
+        return NULL;
+    }
+    entry->next = planf_cache;
+    planf_cache = entry;
+    pthread_mutex_unlock(&planner_lock);
+    return entry->plan;
+}
+
+void fft_plan_cache_clear(void) {
+    pthread_mutex_lock(&planner_lock);
+    while (plan_cache != NULL) {
+        struct PlanCacheEntry* next = plan_cache->next;
+        fft_plan_destroy(plan_cache->plan);
+        free(plan_cache);
+        plan_cache = next;
+    }
+    while (algorithm_plan_cache != NULL) {
+        struct PlanCacheEntry* next = algorithm_plan_cache->next;
+        fft_plan_destroy(algorithm_plan_cache->plan);
+        free(algorithm_plan_cache);
+        algorithm_plan_cache = next;
+    }
+    while (real_plan_cache != NULL) {
+        struct RealPlanCacheEntry* next = real_plan_cache->next;
+        rfft_plan_destroy(real_plan_cache->plan);
+        free(real_plan_cache);
+        real_plan_cache = next;
+    }
+    while (planf_cache != NULL) {
+        struct PlanFCacheEntry* next = planf_cache->next;
+        fft_planf_destroy(planf_cache->plan);
+        free(planf_cache);
+        planf_cache = next;
+    }
+    pthread_mutex_unlock(&planner_lock);
+}
+
+static struct Complex* planned_fft(const struct Complex* x, const int N, const int inverse) {
+    const int four_step_min = fft_get_threads() > 1 ? FFT_FOUR_STEP_MIN_THREADED : FFT_FOUR_STEP_MIN;
+    if (N >= four_step_min && fft_four_step_split(N) != 0) {
+        return fft_four_step_base(x, N, inverse);
+    }
+    const struct FFTPlan* plan = fft_plan_get(N, inverse);
+    if (plan == NULL) {
+        return NULL;
+    }
+    return fft_plan_execute(plan, x);
+}
+
+struct Complex* fft(const struct Complex* x, const int N) {
+    return planned_fft(x, N, 0);
+}
+
+struct Complex* ifft(const struct Complex* x, const int N) {
+    return planned_fft(x, N, 1);
+}
+
+static int planned_fft_split(const double* re, const double* im, double* re_out, double* im_out, const int N,
+                             const int inverse) {
+    const struct FFTPlan* plan = fft_plan_get(N, inverse);
+    if (plan == NULL) {
+        return -1;
+    }
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct Complex* work = fft_arena_cplx_arr(arena, fft_plan_split_work_size(plan));
+    if (work == NULL) {
+        fprintf(stderr, "fft_split failed\n");
+        fft_arena_release(arena, mark);
+        return -1;
+    }
+    fft_plan_execute_split(plan, re, im, re_out, im_out, work);
+    fft_arena_release(arena, mark);
+    return 0;
+}
+
+int fft_split(const double* re, const double* im, double* re_out, double* im_out, const int N) {
+    return planned_fft_split(re, im, re_out, im_out, N, 0);
+}
+
+int ifft_split(const double* re, const double* im, double* re_out, double* im_out, const int N) {
+    return planned_fft_split(re, im, re_out, im_out, N, 1);
+}
@@ -0,0 +1,73 @@
+#ifndef PLANNER_H
+#define PLANNER_H
+#include <stdio.h>
+
+#include "complex.h"
+#include "fftf.h"
+#include "plan.h"
+#include "rfft.h"
+
+/* PLANNER */
+enum PlannerMode {
+    PLANNER_ESTIMATE,   /* pick the engine from the factorization of N (fft_plan_create) */
+    PLANNER_MEASURE     /* time every applicable engine once per length and keep the fastest */
+};
+
+void fft_planner_set_mode(enum PlannerMode mode);
+
+enum PlannerMode fft_planner_get_mode(void);
+
+/* Builds every engine applicable to N, times them and returns the fastest. */
+struct FFTPlan* fft_plan_measure(int N, int inverse);
+
+/* A new plan owned by the caller, chosen from wisdom or by the current planner mode. */
+struct FFTPlan* fft_planner_create(int N, int inverse);
+
+/* Process-wide plan cache keyed by (N, inverse). Returned plans are owned by the cache. */
+const struct FFTPlan* fft_plan_get(int N, int inverse);
+
+/*
+ * The same for plans of one given algorithm (fft_plan_create_algorithm), keyed
+ * by (N, inverse, algorithm): a forward and an inverse plan from here share
+ * their scrambled order, which fft_plan_get does not promise.
+ */
+const struct FFTPlan* fft_plan_get_algorithm(int N, int inverse, enum PlanAlgorithm algorithm);
+
+/* The same for real plans (rfft_plan_create) and float plans (fft_planf_create); fft_plan_cache_clear empties all four. */
+const struct RealFFTPlan* rfft_plan_get(int N, int inverse);
+
+const struct FFTPlanF* fft_planf_get(int N, int inverse);
+
+void fft_plan_cache_clear(void);
+
+/*
+ * WISDOM
+ * Text file: a "fft-c-wisdom <version>" line, a "cpu <signature>" line, then one
+ * "<N> <inverse> <ALGORITHM> <radices|->" line per measured length. Wisdom from
+ * another CPU is ignored, and lengths without an entry are planned as usual.
+ */
+#define WISDOM_ENV "FFT_C_WISDOM"   /* imported before the first plan or wisdom call, if the file exists */
+
+int fft_wisdom_export(const char* filename);
+
+int fft_wisdom_import(const char* filename);
+
+/* The same on an open stream, e.g. from tmpfile(); the caller keeps ownership of it. */
+int fft_wisdom_export_file(FILE* file);
+
+int fft_wisdom_import_file(FILE* file);
+
+/* Also drops the FFT_C_WISDOM wisdom for the rest of the process. */
+void fft_wisdom_forget(void);
+
+/* Any length; dispatches through the plan cache, or to the four-step FFT for very long transforms. */
+struct Complex* fft(const struct Complex* x, int N);
+
+struct Complex* ifft(const struct Complex* x, int N);
+
+/* Split-complex fft / ifft into re_out / im_out (which may be re / im); im may be NULL for real input. -1 on failure. */
+int fft_split(const double* re, const double* im, double* re_out, double* im_out, int N);
+
+int ifft_split(const double* re, const double* im, double* re_out, double* im_out, int N);
+
+#endif //PLANNER_H
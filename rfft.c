@@ -0,0 +1,259 @@
+#include "rfft.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "arena.h"
+#include "complex.h"
+#include "fft.h"
+#include "plan.h"
+#include "planner.h"
+#include "threads.h"
+#include "util.h"
+
+struct RealFFTPlan* rfft_plan_create(const int N, const int inverse) {
+    if (N < 1) {
+        fprintf(stderr, "rfft_plan_create: invalid N=%d\n", N);
+        return NULL;
+    }
+
+    struct RealFFTPlan* plan = calloc(1, sizeof(struct RealFFTPlan));
+    if (plan == NULL) {
+        fprintf(stderr, "rfft_plan_create failed\n");
+        return NULL;
+    }
+    plan->N = N;
+    plan->inverse = inverse;
+
+    if (N % 2 != 0) {
+        plan->plan = fft_planner_create(N, inverse);
+        if (plan->plan == NULL) {
+            rfft_plan_destroy(plan);
+            return NULL;
+        }
+        return plan;
+    }
+
+    const int half = N / 2;
+    plan->plan = fft_planner_create(half, inverse);
+    plan->twiddles = malloc_cplx_arr(half);
+    if (plan->plan == NULL || plan->twiddles == NULL) {
+        rfft_plan_destroy(plan);
+        return NULL;
+    }
+    for (int k = 0; k < half; k++) {
+        plan->twiddles[k] = exp_q(-2.0 * M_PI * k / N);
+    }
+    return plan;
+}
+
+int rfft_plan_work_size(const struct RealFFTPlan* plan) {
+    const int length = plan->N % 2 == 0 ? plan->N / 2 : plan->N;
+    return length + fft_plan_work_size(plan->plan);
+}
+
+void rfft_plan_execute_r2c(const struct RealFFTPlan* plan, const double* x, struct Complex* X,
+                           struct Complex* work) {
+    const int N = plan->N;
+
+    if (N % 2 != 0) {
+        for (int n = 0; n < N; n++) {
+            work[n] = (struct Complex){x[n], 0};
+        }
+        fft_plan_execute_work(plan->plan, work, work, work + N);
+        for (int k = 0; k <= N / 2; k++) {
+            X[k] = work[k];
+        }
+        return;
+    }
+
+    /* z[n] = x[2n] + i*x[2n+1] */
+    const int half = N / 2;
+    struct Complex* Z = work;
+    for (int n = 0; n < half; n++) {
+        Z[n] = (struct Complex){x[2 * n], x[2 * n + 1]};
+    }
+    fft_plan_execute_work(plan->plan, Z, Z, work + half);
+
+    /* Split Z into the spectra E and O of the even and odd samples: X[k] = E[k] + W^k * O[k]. */
+    X[0] = (struct Complex){Z[0].real + Z[0].imag, 0};
+    X[half] = (struct Complex){Z[0].real - Z[0].imag, 0};
+    /* The arithmetic is written out: these loops run once per transform and out-of-line calls dominated them. */
+    for (int k = 1; k < half; k++) {
+        const struct Complex z_k = Z[k];
+        const struct Complex z_mirror = {Z[half - k].real, -Z[half - k].imag};
+        const struct Complex even = {0.5 * (z_k.real + z_mirror.real), 0.5 * (z_k.imag + z_mirror.imag)};
+        /* (z_k - z_mirror) / 2i */
+        const struct Complex odd = {0.5 * (z_k.imag - z_mirror.imag), -0.5 * (z_k.real - z_mirror.real)};
+        const struct Complex w = plan->twiddles[k];
+        X[k] = (struct Complex){even.real + (w.real * odd.real - w.imag * odd.imag),
+                                even.imag + (w.real * odd.imag + w.imag * odd.real)};
+    }
+}
+
+void rfft_plan_execute_c2r(const struct RealFFTPlan* plan, const struct Complex* X, double* x,
+                           struct Complex* work) {
+    const int N = plan->N;
+
+    if (N % 2 != 0) {
+        work[0] = X[0];
+        for (int k = 1; k <= N / 2; k++) {
+            work[k] = X[k];
+            work[N - k] = conj_q(X[k]);
+        }
+        fft_plan_execute_work(plan->plan, work, work, work + N);
+        for (int n = 0; n < N; n++) {
+            x[n] = work[n].real;
+        }
+        return;
+    }
+
+    /* Rebuild Z[k] = E[k] + i*O[k] from X[k] and X[N/2 - k], then invert the half-length transform. */
+    const int half = N / 2;
+    struct Complex* Z = work;
+    for (int k = 0; k < half; k++) {
+        const struct Complex x_k = X[k];
+        const struct Complex x_mirror = {X[half - k].real, -X[half - k].imag};
+        const struct Complex even = {0.5 * (x_k.real + x_mirror.real), 0.5 * (x_k.imag + x_mirror.imag)};
+        const struct Complex diff = {0.5 * (x_k.real - x_mirror.real), 0.5 * (x_k.imag - x_mirror.imag)};
+        /* diff * conj(W^k) */
+        const struct Complex w = plan->twiddles[k];
+        const struct Complex odd = {diff.real * w.real + diff.imag * w.imag, diff.imag * w.real - diff.real * w.imag};
+        Z[k] = (struct Complex){even.real - odd.imag, even.imag + odd.real};
+    }
+    fft_plan_execute_work(plan->plan, Z, Z, work + half);
+
+    for (int n = 0; n < half; n++) {
+        x[2 * n] = Z[n].real;
+        x[2 * n + 1] = Z[n].imag;
+    }
+}
+
+void rfft_plan_destroy(struct RealFFTPlan* plan) {
+    if (plan == NULL) {
+        return;
+    }
+    fft_plan_destroy(plan->plan);
+    fft_free(plan->twiddles);
+    free(plan);
+}
+
+struct Complex* rfft(const double* x, const int N) {
+    const struct RealFFTPlan* plan = rfft_plan_get(N, 0);
+    if (plan == NULL) {
+        return NULL;
+    }
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct Complex* X = malloc_cplx_arr(N / 2 + 1);
+    struct Complex* work = fft_arena_cplx_arr(arena, rfft_plan_work_size(plan));
+    if (X == NULL || work == NULL) {
+        fprintf(stderr, "rfft failed\n");
+        fft_free(X);
+        fft_arena_release(arena, mark);
+        return NULL;
+    }
+    rfft_plan_execute_r2c(plan, x, X, work);
+    fft_arena_release(arena, mark);
+    return X;
+}
+
+double* irfft(const struct Complex* X, const int N) {
+    const struct RealFFTPlan* plan = rfft_plan_get(N, 1);
+    if (plan == NULL) {
+        return NULL;
+    }
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    double* x = malloc(N * sizeof(double));
+    struct Complex* work = fft_arena_cplx_arr(arena, rfft_plan_work_size(plan));
+    if (x == NULL || work == NULL) {
+        fprintf(stderr, "irfft failed\n");
+        free(x);
+        fft_arena_release(arena, mark);
+        return NULL;
+    }
+    rfft_plan_execute_c2r(plan, X, x, work);
+    fft_arena_release(arena, mark);
+    return x;
+}
+
+struct RealPass2D {
+    const struct RealFFTPlan* plan;
+    const double* x;
+    struct Complex2D* X;
+    double* x_out;
+    atomic_int failed;
+};
+
+static void rfft_2d_rows_range(void* ctx, const int begin, const int end, const int thread) {
+    (void) thread;
+    struct RealPass2D* pass = ctx;
+    const int width = pass->plan->N;
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct Complex* work = fft_arena_cplx_arr(arena, rfft_plan_work_size(pass->plan));
+    if (work == NULL) {
+        atomic_store(&pass->failed, 1);
+        fft_arena_release(arena, mark);
+        return;
+    }
+    for (int i = begin; i < end; i++) {
+        if (pass->plan->inverse) {
+            rfft_plan_execute_c2r(pass->plan, cplx_2d_row(pass->X, i), pass->x_out + (size_t) i * width, work);
+        } else {
+            rfft_plan_execute_r2c(pass->plan, pass->x + (size_t) i * width, cplx_2d_row(pass->X, i), work);
+        }
+    }
+    fft_arena_release(arena, mark);
+}
+
+struct Complex2D* rfft_2d(const double* x, const int height, const int width) {
+    const struct RealFFTPlan* plan = rfft_plan_get(width, 0);
+    struct Complex2D* X = malloc_2d_cplx_arr(height, width / 2 + 1);
+    const struct FFTPlan* col_plan = fft_plan_get(height, 0);
+    if (plan == NULL || X == NULL || col_plan == NULL) {
+        free_2d(X);
+        return NULL;
+    }
+
+    struct RealPass2D pass = {plan, x, X, NULL, 0};
+    parallel_for(height, 1, rfft_2d_rows_range, &pass);
+    if (atomic_load(&pass.failed) || fft_2d_cols(X, X, col_plan) != 0) {
+        fprintf(stderr, "rfft_2d failed\n");
+        free_2d(X);
+        return NULL;
+    }
+    return X;
+}
+
+double* irfft_2d(const struct Complex2D* X, const int width) {
+    const int height = X->height;
+    struct Complex2D* Y = malloc_2d_cplx_arr(height, X->width);
+    const struct RealFFTPlan* plan = rfft_plan_get(width, 1);
+    const struct FFTPlan* col_plan = fft_plan_get(height, 1);
+    double* x = malloc((size_t) height * width * sizeof(double));
+    if (Y == NULL || plan == NULL || col_plan == NULL || x == NULL) {
+        fprintf(stderr, "irfft_2d failed\n");
+        free_2d(Y);
+        free(x);
+        return NULL;
+    }
+
+    struct RealPass2D pass = {plan, NULL, Y, x, 0};
+    if (fft_2d_cols(Y, X, col_plan) != 0) {
+        atomic_store(&pass.failed, 1);
+    } else {
+        parallel_for(height, 1, rfft_2d_rows_range, &pass);
+    }
+
+    free_2d(Y);
+    if (atomic_load(&pass.failed)) {
+        fprintf(stderr, "irfft_2d failed\n");
+        free(x);
+        return NULL;
+    }
+    return x;
+}
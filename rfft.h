@@ -0,0 +1,48 @@
+#ifndef RFFT_H
+#define RFFT_H
+#include "complex.h"
+#include "plan.h"
+#include "util.h"
+
+/*
+ * REAL FFT
+ * A real signal of length N has a Hermitian spectrum, so only bins 0..N/2 are
+ * stored. For even N the N real samples are packed into an N/2-point complex
+ * transform; odd N falls back to a full-length complex transform.
+ */
+struct RealFFTPlan {
+    int N;
+    int inverse;                /* 0: real-to-complex, 1: complex-to-real */
+    struct FFTPlan* plan;       /* length N/2 (even N) or N (odd N) */
+    struct Complex* twiddles;   /* exp(-2*pi*i*k/N) for k < N/2, even N only */
+};
+
+struct RealFFTPlan* rfft_plan_create(int N, int inverse);
+
+/* Work buffer length (in elements) needed by the execute functions. */
+int rfft_plan_work_size(const struct RealFFTPlan* plan);
+
+/* x: N real samples, X: N/2 + 1 bins. */
+void rfft_plan_execute_r2c(const struct RealFFTPlan* plan, const double* x, struct Complex* X,
+                           struct Complex* work);
+
+/* X: N/2 + 1 bins, x: N real samples (scaled by 1/N, like the other inverse transforms). */
+void rfft_plan_execute_c2r(const struct RealFFTPlan* plan, const struct Complex* X, double* x,
+                           struct Complex* work);
+
+void rfft_plan_destroy(struct RealFFTPlan* plan);
+
+/* Returns N/2 + 1 bins. */
+struct Complex* rfft(const double* x, int N);
+
+/* Takes N/2 + 1 bins, returns N real samples. */
+double* irfft(const struct Complex* X, int N);
+
+/* REAL 2D FFT */
+/* x: flat height x width real plane. Returns height rows of width/2 + 1 bins. */
+struct Complex2D* rfft_2d(const double* x, int height, int width);
+
+/* X: height rows of width/2 + 1 bins. Returns a flat height x width real plane. */
+double* irfft_2d(const struct Complex2D* X, int width);
+
+#endif //RFFT_H
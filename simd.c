@@ -0,0 +1,1169 @@
+#include "simd.h"
+
+#include "complex.h"
+#include "complexf.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#else
+#define SIMD_X86 0
+#endif
+
+static enum SimdLevel simd_cap = SIMD_AVX512;
+
+enum SimdLevel simd_detect(void) {
+#if SIMD_X86
+    if (__builtin_cpu_supports("avx512f")) {
+        return SIMD_AVX512;
+    }
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+        return SIMD_AVX2;
+    }
+    if (__builtin_cpu_supports("sse2")) {
+        return SIMD_SSE2;
+    }
+#endif
+    return SIMD_SCALAR;
+}
+
+void simd_set_level(const enum SimdLevel level) {
+    simd_cap = level;
+}
+
+enum SimdLevel simd_get_level(void) {
+    const enum SimdLevel detected = simd_detect();
+    return simd_cap < detected ? simd_cap : detected;
+}
+
+const char* simd_level_name(const enum SimdLevel level) {
+    switch (level) {
+        case SIMD_SCALAR: return "SCALAR";
+        case SIMD_SSE2: return "SSE2";
+        case SIMD_AVX2: return "AVX2";
+        case SIMD_AVX512: return "AVX512";
+    }
+    return "UNKNOWN";
+}
+
+#if SIMD_X86
+
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define TARGET_AVX512 __attribute__((target("avx512f")))
+
+/* SSE2: one complex (real, imag) per vector. */
+static inline TARGET_SSE2 __m128d cmul_sse2(const __m128d a, const __m128d w) {
+    const __m128d w_re = _mm_unpacklo_pd(w, w);
+    const __m128d w_im = _mm_unpackhi_pd(w, w);
+    const __m128d a_swap = _mm_shuffle_pd(a, a, 1);
+    /* (ar*wr - ai*wi, ai*wr + ar*wi) */
+    return _mm_add_pd(_mm_mul_pd(a, w_re), _mm_xor_pd(_mm_mul_pd(a_swap, w_im), _mm_set_pd(0.0, -0.0)));
+}
+
+/* d * -i for the forward transform, d * i for the inverse. */
+static inline TARGET_SSE2 __m128d rotate_sse2(const __m128d d, const int inverse) {
+    const __m128d d_swap = _mm_shuffle_pd(d, d, 1);
+    return _mm_xor_pd(d_swap, inverse ? _mm_set_pd(0.0, -0.0) : _mm_set_pd(-0.0, 0.0));
+}
+
+static TARGET_SSE2 void radix_2_stage_sse2(struct Complex* X, const int N, const int half, const struct Complex* w) {
+    for (int k = 0; k < N; k += 2 * half) {
+        double* a = (double*) (X + k);
+        double* b = (double*) (X + k + half);
+        for (int j = 0; j < half; j++) {
+            const __m128d u = _mm_loadu_pd(a + 2 * j);
+            const __m128d t = cmul_sse2(_mm_loadu_pd(b + 2 * j), _mm_loadu_pd((const double*) (w + j)));
+            _mm_storeu_pd(a + 2 * j, _mm_add_pd(u, t));
+            _mm_storeu_pd(b + 2 * j, _mm_sub_pd(u, t));
+        }
+    }
+}
+
+static TARGET_SSE2 void radix_4_stage_sse2(struct Complex* X, const int N, const int h, const struct Complex* w,
+                                           const int inverse) {
+    const double* w1 = (const double*) w;
+    const double* w2 = (const double*) (w + h);
+    const double* w3 = (const double*) (w + 2 * h);
+    for (int k = 0; k < N; k += 4 * h) {
+        double* x0 = (double*) (X + k);
+        double* x1 = (double*) (X + k + h);
+        double* x2 = (double*) (X + k + 2 * h);
+        double* x3 = (double*) (X + k + 3 * h);
+        for (int j = 0; j < 2 * h; j += 2) {
+            const __m128d a0 = _mm_loadu_pd(x0 + j);
+            const __m128d t1 = cmul_sse2(_mm_loadu_pd(x1 + j), _mm_loadu_pd(w1 + j));
+            const __m128d t2 = cmul_sse2(_mm_loadu_pd(x2 + j), _mm_loadu_pd(w2 + j));
+            const __m128d t3 = cmul_sse2(_mm_loadu_pd(x3 + j), _mm_loadu_pd(w3 + j));
+
+            const __m128d s0 = _mm_add_pd(a0, t1);
+            const __m128d d0 = _mm_sub_pd(a0, t1);
+            const __m128d s1 = _mm_add_pd(t2, t3);
+            const __m128d r1 = rotate_sse2(_mm_sub_pd(t2, t3), inverse);
+
+            _mm_storeu_pd(x0 + j, _mm_add_pd(s0, s1));
+            _mm_storeu_pd(x1 + j, _mm_add_pd(d0, r1));
+            _mm_storeu_pd(x2 + j, _mm_sub_pd(s0, s1));
+            _mm_storeu_pd(x3 + j, _mm_sub_pd(d0, r1));
+        }
+    }
+}
+
+/* AVX2: two complex per vector; fmaddsub subtracts in the real lanes and adds in the imaginary ones. */
+static inline TARGET_AVX2 __m256d cmul_avx2(const __m256d a, const __m256d w) {
+    const __m256d w_re = _mm256_movedup_pd(w);
+    const __m256d w_im = _mm256_permute_pd(w, 0xF);
+    const __m256d a_swap = _mm256_permute_pd(a, 0x5);
+    return _mm256_fmaddsub_pd(a, w_re, _mm256_mul_pd(a_swap, w_im));
+}
+
+static inline TARGET_AVX2 __m256d rotate_avx2(const __m256d d, const int inverse) {
+    const __m256d d_swap = _mm256_permute_pd(d, 0x5);
+    return _mm256_xor_pd(d_swap, inverse ? _mm256_set_pd(0.0, -0.0, 0.0, -0.0) : _mm256_set_pd(-0.0, 0.0, -0.0, 0.0));
+}
+
+static TARGET_AVX2 void radix_2_stage_avx2(struct Complex* X, const int N, const int half, const struct Complex* w) {
+    for (int k = 0; k < N; k += 2 * half) {
+        double* a = (double*) (X + k);
+        double* b = (double*) (X + k + half);
+        for (int j = 0; j < 2 * half; j += 4) {
+            const __m256d u = _mm256_loadu_pd(a + j);
+            const __m256d t = cmul_avx2(_mm256_loadu_pd(b + j), _mm256_loadu_pd((const double*) w + j));
+            _mm256_storeu_pd(a + j, _mm256_add_pd(u, t));
+            _mm256_storeu_pd(b + j, _mm256_sub_pd(u, t));
+        }
+    }
+}
+
+static TARGET_AVX2 void radix_4_stage_avx2(struct Complex* X, const int N, const int h, const struct Complex* w,
+                                           const int inverse) {
+    const double* w1 = (const double*) w;
+    const double* w2 = (const double*) (w + h);
+    const double* w3 = (const double*) (w + 2 * h);
+    for (int k = 0; k < N; k += 4 * h) {
+        double* x0 = (double*) (X + k);
+        double* x1 = (double*) (X + k + h);
+        double* x2 = (double*) (X + k + 2 * h);
+        double* x3 = (double*) (X + k + 3 * h);
+        for (int j = 0; j < 2 * h; j += 4) {
+            const __m256d a0 = _mm256_loadu_pd(x0 + j);
+            const __m256d t1 = cmul_avx2(_mm256_loadu_pd(x1 + j), _mm256_loadu_pd(w1 + j));
+            const __m256d t2 = cmul_avx2(_mm256_loadu_pd(x2 + j), _mm256_loadu_pd(w2 + j));
+            const __m256d t3 = cmul_avx2(_mm256_loadu_pd(x3 + j), _mm256_loadu_pd(w3 + j));
+
+            const __m256d s0 = _mm256_add_pd(a0, t1);
+            const __m256d d0 = _mm256_sub_pd(a0, t1);
+            const __m256d s1 = _mm256_add_pd(t2, t3);
+            const __m256d r1 = rotate_avx2(_mm256_sub_pd(t2, t3), inverse);
+
+            _mm256_storeu_pd(x0 + j, _mm256_add_pd(s0, s1));
+            _mm256_storeu_pd(x1 + j, _mm256_add_pd(d0, r1));
+            _mm256_storeu_pd(x2 + j, _mm256_sub_pd(s0, s1));
+            _mm256_storeu_pd(x3 + j, _mm256_sub_pd(d0, r1));
+        }
+    }
+}
+
+/* AVX-512F: four complex per vector; negation by masked subtraction, as AVX-512F has no double xor. */
+static inline TARGET_AVX512 __m512d cmul_avx512(const __m512d a, const __m512d w) {
+    const __m512d w_re = _mm512_movedup_pd(w);
+    const __m512d w_im = _mm512_permute_pd(w, 0xFF);
+    const __m512d a_swap = _mm512_permute_pd(a, 0x55);
+    return _mm512_fmaddsub_pd(a, w_re, _mm512_mul_pd(a_swap, w_im));
+}
+
+static inline TARGET_AVX512 __m512d rotate_avx512(const __m512d d, const int inverse) {
+    const __m512d d_swap = _mm512_permute_pd(d, 0x55);
+    return _mm512_mask_sub_pd(d_swap, inverse ? 0x55 : 0xAA, _mm512_setzero_pd(), d_swap);
+}
+
+static TARGET_AVX512 void radix_2_stage_avx512(struct Complex* X, const int N, const int half,
+                                               const struct Complex* w) {
+    for (int k = 0; k < N; k += 2 * half) {
+        double* a = (double*) (X + k);
+        double* b = (double*) (X + k + half);
+        for (int j = 0; j < 2 * half; j += 8) {
+            const __m512d u = _mm512_loadu_pd(a + j);
+            const __m512d t = cmul_avx512(_mm512_loadu_pd(b + j), _mm512_loadu_pd((const double*) w + j));
+            _mm512_storeu_pd(a + j, _mm512_add_pd(u, t));
+            _mm512_storeu_pd(b + j, _mm512_sub_pd(u, t));
+        }
+    }
+}
+
+static TARGET_AVX512 void radix_4_stage_avx512(struct Complex* X, const int N, const int h, const struct Complex* w,
+                                               const int inverse) {
+    const double* w1 = (const double*) w;
+    const double* w2 = (const double*) (w + h);
+    const double* w3 = (const double*) (w + 2 * h);
+    for (int k = 0; k < N; k += 4 * h) {
+        double* x0 = (double*) (X + k);
+        double* x1 = (double*) (X + k + h);
+        double* x2 = (double*) (X + k + 2 * h);
+        double* x3 = (double*) (X + k + 3 * h);
+        for (int j = 0; j < 2 * h; j += 8) {
+            const __m512d a0 = _mm512_loadu_pd(x0 + j);
+            const __m512d t1 = cmul_avx512(_mm512_loadu_pd(x1 + j), _mm512_loadu_pd(w1 + j));
+            const __m512d t2 = cmul_avx512(_mm512_loadu_pd(x2 + j), _mm512_loadu_pd(w2 + j));
+            const __m512d t3 = cmul_avx512(_mm512_loadu_pd(x3 + j), _mm512_loadu_pd(w3 + j));
+
+            const __m512d s0 = _mm512_add_pd(a0, t1);
+            const __m512d d0 = _mm512_sub_pd(a0, t1);
+            const __m512d s1 = _mm512_add_pd(t2, t3);
+            const __m512d r1 = rotate_avx512(_mm512_sub_pd(t2, t3), inverse);
+
+            _mm512_storeu_pd(x0 + j, _mm512_add_pd(s0, s1));
+            _mm512_storeu_pd(x1 + j, _mm512_add_pd(d0, r1));
+            _mm512_storeu_pd(x2 + j, _mm512_sub_pd(s0, s1));
+            _mm512_storeu_pd(x3 + j, _mm512_sub_pd(d0, r1));
+        }
+    }
+}
+
+/*
+ * Stockham autosort passes (radix 2 and 4) and decimation-in-frequency stages,
+ * the transposes of the stages above. A Stockham pass reads x[q + s*(j + k*m)]
+ * and writes y[q + s*(p*j + r)], so its inner loop runs over q with one
+ * broadcast twiddle per output leg; the vector width must divide s.
+ */
+
+static TARGET_SSE2 void stockham_2_sse2(const struct Complex* x, struct Complex* y, const int m, const int s,
+                                         const struct Complex* twiddles) {
+    for (int j = 0; j < m; j++) {
+        const __m128d w1 = _mm_loadu_pd((const double*) (twiddles + j * s));
+        const double* x0 = (const double*) (x + s * j);
+        const double* x1 = (const double*) (x + s * (j + m));
+        double* y0 = (double*) (y + 2 * s * j);
+        double* y1 = y0 + 2 * s;
+        for (int q = 0; q < 2 * s; q += 2) {
+            const __m128d a0 = _mm_loadu_pd(x0 + q);
+            const __m128d a1 = _mm_loadu_pd(x1 + q);
+            _mm_storeu_pd(y0 + q, _mm_add_pd(a0, a1));
+            _mm_storeu_pd(y1 + q, cmul_sse2(_mm_sub_pd(a0, a1), w1));
+        }
+    }
+}
+
+static TARGET_SSE2 void stockham_4_sse2(const struct Complex* x, struct Complex* y, const int m, const int s,
+                                         const struct Complex* twiddles, const int inverse) {
+    for (int j = 0; j < m; j++) {
+        const __m128d w1 = _mm_loadu_pd((const double*) (twiddles + j * s));
+        const __m128d w2 = _mm_loadu_pd((const double*) (twiddles + 2 * j * s));
+        const __m128d w3 = _mm_loadu_pd((const double*) (twiddles + 3 * j * s));
+        const double* x0 = (const double*) (x + s * j);
+        const double* x1 = (const double*) (x + s * (j + m));
+        const double* x2 = (const double*) (x + s * (j + 2 * m));
+        const double* x3 = (const double*) (x + s * (j + 3 * m));
+        double* y0 = (double*) (y + 4 * s * j);
+        double* y1 = y0 + 2 * s;
+        double* y2 = y0 + 4 * s;
+        double* y3 = y0 + 6 * s;
+        for (int q = 0; q < 2 * s; q += 2) {
+            const __m128d a0 = _mm_loadu_pd(x0 + q);
+            const __m128d a1 = _mm_loadu_pd(x1 + q);
+            const __m128d a2 = _mm_loadu_pd(x2 + q);
+            const __m128d a3 = _mm_loadu_pd(x3 + q);
+
+            const __m128d s0 = _mm_add_pd(a0, a2);
+            const __m128d d0 = _mm_sub_pd(a0, a2);
+            const __m128d s1 = _mm_add_pd(a1, a3);
+            const __m128d r1 = rotate_sse2(_mm_sub_pd(a1, a3), inverse);
+
+            _mm_storeu_pd(y0 + q, _mm_add_pd(s0, s1));
+            _mm_storeu_pd(y1 + q, cmul_sse2(_mm_add_pd(d0, r1), w1));
+            _mm_storeu_pd(y2 + q, cmul_sse2(_mm_sub_pd(s0, s1), w2));
+            _mm_storeu_pd(y3 + q, cmul_sse2(_mm_sub_pd(d0, r1), w3));
+        }
+    }
+}
+
+static TARGET_SSE2 void radix_2_stage_dif_sse2(struct Complex* X, const int N, const int half,
+                                                const struct Complex* w) {
+    for (int k = 0; k < N; k += 2 * half) {
+        double* a = (double*) (X + k);
+        double* b = (double*) (X + k + half);
+        for (int j = 0; j < 2 * half; j += 2) {
+            const __m128d u = _mm_loadu_pd(a + j);
+            const __m128d v = _mm_loadu_pd(b + j);
+            _mm_storeu_pd(a + j, _mm_add_pd(u, v));
+            _mm_storeu_pd(b + j, cmul_sse2(_mm_sub_pd(u, v), _mm_loadu_pd((const double*) w + j)));
+        }
+    }
+}
+
+static TARGET_SSE2 void radix_4_stage_dif_sse2(struct Complex* X, const int N, const int h, const struct Complex* w,
+                                                const int inverse) {
+    const double* w1 = (const double*) w;
+    const double* w2 = (const double*) (w + h);
+    const double* w3 = (const double*) (w + 2 * h);
+    for (int k = 0; k < N; k += 4 * h) {
+        double* x0 = (double*) (X + k);
+        double* x1 = (double*) (X + k + h);
+        double* x2 = (double*) (X + k + 2 * h);
+        double* x3 = (double*) (X + k + 3 * h);
+        for (int j = 0; j < 2 * h; j += 2) {
+            const __m128d a0 = _mm_loadu_pd(x0 + j);
+            const __m128d a1 = _mm_loadu_pd(x1 + j);
+            const __m128d a2 = _mm_loadu_pd(x2 + j);
+            const __m128d a3 = _mm_loadu_pd(x3 + j);
+
+            const __m128d s0 = _mm_add_pd(a0, a2);
+            const __m128d d0 = _mm_sub_pd(a0, a2);
+            const __m128d s1 = _mm_add_pd(a1, a3);
+            const __m128d r1 = rotate_sse2(_mm_sub_pd(a1, a3), inverse);
+
+            _mm_storeu_pd(x0 + j, _mm_add_pd(s0, s1));
+            _mm_storeu_pd(x1 + j, cmul_sse2(_mm_sub_pd(s0, s1), _mm_loadu_pd(w1 + j)));
+            _mm_storeu_pd(x2 + j, cmul_sse2(_mm_add_pd(d0, r1), _mm_loadu_pd(w2 + j)));
+            _mm_storeu_pd(x3 + j, cmul_sse2(_mm_sub_pd(d0, r1), _mm_loadu_pd(w3 + j)));
+        }
+    }
+}
+
+static TARGET_AVX2 void stockham_2_avx2(const struct Complex* x, struct Complex* y, const int m, const int s,
+                                         const struct Complex* twiddles) {
+    for (int j = 0; j < m; j++) {
+        const __m256d w1 = _mm256_broadcast_pd((const __m128d*) (twiddles + j * s));
+        const double* x0 = (const double*) (x + s * j);
+        const double* x1 = (const double*) (x + s * (j + m));
+        double* y0 = (double*) (y + 2 * s * j);
+        double* y1 = y0 + 2 * s;
+        for (int q = 0; q < 2 * s; q += 4) {
+            const __m256d a0 = _mm256_loadu_pd(x0 + q);
+            const __m256d a1 = _mm256_loadu_pd(x1 + q);
+            _mm256_storeu_pd(y0 + q, _mm256_add_pd(a0, a1));
+            _mm256_storeu_pd(y1 + q, cmul_avx2(_mm256_sub_pd(a0, a1), w1));
+        }
+    }
+}
+
+static TARGET_AVX2 void stockham_4_avx2(const struct Complex* x, struct Complex* y, const int m, const int s,
+                                         const struct Complex* twiddles, const int inverse) {
+    for (int j = 0; j < m; j++) {
+        const __m256d w1 = _mm256_broadcast_pd((const __m128d*) (twiddles + j * s));
+        const __m256d w2 = _mm256_broadcast_pd((const __m128d*) (twiddles + 2 * j * s));
+        const __m256d w3 = _mm256_broadcast_pd((const __m128d*) (twiddles + 3 * j * s));
+        const double* x0 = (const double*) (x + s * j);
+        const double* x1 = (const double*) (x + s * (j + m));
+        const double* x2 = (const double*) (x + s * (j + 2 * m));
+        const double* x3 = (const double*) (x + s * (j + 3 * m));
+        double* y0 = (double*) (y + 4 * s * j);
+        double* y1 = y0 + 2 * s;
+        double* y2 = y0 + 4 * s;
+        double* y3 = y0 + 6 * s;
+        for (int q = 0; q < 2 * s; q += 4) {
+            const __m256d a0 = _mm256_loadu_pd(x0 + q);
+            const __m256d a1 = _mm256_loadu_pd(x1 + q);
+            const __m256d a2 = _mm256_loadu_pd(x2 + q);
+            const __m256d a3 = _mm256_loadu_pd(x3 + q);
+
+            const __m256d s0 = _mm256_add_pd(a0, a2);
+            const __m256d d0 = _mm256_sub_pd(a0, a2);
+            const __m256d s1 = _mm256_add_pd(a1, a3);
+            const __m256d r1 = rotate_avx2(_mm256_sub_pd(a1, a3), inverse);
+
+            _mm256_storeu_pd(y0 + q, _mm256_add_pd(s0, s1));
+            _mm256_storeu_pd(y1 + q, cmul_avx2(_mm256_add_pd(d0, r1), w1));
+            _mm256_storeu_pd(y2 + q, cmul_avx2(_mm256_sub_pd(s0, s1), w2));
+            _mm256_storeu_pd(y3 + q, cmul_avx2(_mm256_sub_pd(d0, r1), w3));
+        }
+    }
+}
+
+static TARGET_AVX2 void radix_2_stage_dif_avx2(struct Complex* X, const int N, const int half,
+                                                const struct Complex* w) {
+    for (int k = 0; k < N; k += 2 * half) {
+        double* a = (double*) (X + k);
+        double* b = (double*) (X + k + half);
+        for (int j = 0; j < 2 * half; j += 4) {
+            const __m256d u = _mm256_loadu_pd(a + j);
+            const __m256d v = _mm256_loadu_pd(b + j);
+            _mm256_storeu_pd(a + j, _mm256_add_pd(u, v));
+            _mm256_storeu_pd(b + j, cmul_avx2(_mm256_sub_pd(u, v), _mm256_loadu_pd((const double*) w + j)));
+        }
+    }
+}
+
+static TARGET_AVX2 void radix_4_stage_dif_avx2(struct Complex* X, const int N, const int h, const struct Complex* w,
+                                                const int inverse) {
+    const double* w1 = (const double*) w;
+    const double* w2 = (const double*) (w + h);
+    const double* w3 = (const double*) (w + 2 * h);
+    for (int k = 0; k < N; k += 4 * h) {
+        double* x0 = (double*) (X + k);
+        double* x1 = (double*) (X + k + h);
+        double* x2 = (double*) (X + k + 2 * h);
+        double* x3 = (double*) (X + k + 3 * h);
+        for (int j = 0; j < 2 * h; j += 4) {
+            const __m256d a0 = _mm256_loadu_pd(x0 + j);
+            const __m256d a1 = _mm256_loadu_pd(x1 + j);
+            const __m256d a2 = _mm256_loadu_pd(x2 + j);
+            const __m256d a3 = _mm256_loadu_pd(x3 + j);
+
+            const __m256d s0 = _mm256_add_pd(a0, a2);
+            const __m256d d0 = _mm256_sub_pd(a0, a2);
+            const __m256d s1 = _mm256_add_pd(a1, a3);
+            const __m256d r1 = rotate_avx2(_mm256_sub_pd(a1, a3), inverse);
+
+            _mm256_storeu_pd(x0 + j, _mm256_add_pd(s0, s1));
+            _mm256_storeu_pd(x1 + j, cmul_avx2(_mm256_sub_pd(s0, s1), _mm256_loadu_pd(w1 + j)));
+            _mm256_storeu_pd(x2 + j, cmul_avx2(_mm256_add_pd(d0, r1), _mm256_loadu_pd(w2 + j)));
+            _mm256_storeu_pd(x3 + j, cmul_avx2(_mm256_sub_pd(d0, r1), _mm256_loadu_pd(w3 + j)));
+        }
+    }
+}
+
+static TARGET_AVX512 void stockham_2_avx512(const struct Complex* x, struct Complex* y, const int m, const int s,
+                                         const struct Complex* twiddles) {
+    for (int j = 0; j < m; j++) {
+        const __m512d w1 = _mm512_broadcast_f64x4(_mm256_broadcast_pd((const __m128d*) (twiddles + j * s)));
+        const double* x0 = (const double*) (x + s * j);
+        const double* x1 = (const double*) (x + s * (j + m));
+        double* y0 = (double*) (y + 2 * s * j);
+        double* y1 = y0 + 2 * s;
+        for (int q = 0; q < 2 * s; q += 8) {
+            const __m512d a0 = _mm512_loadu_pd(x0 + q);
+            const __m512d a1 = _mm512_loadu_pd(x1 + q);
+            _mm512_storeu_pd(y0 + q, _mm512_add_pd(a0, a1));
+            _mm512_storeu_pd(y1 + q, cmul_avx512(_mm512_sub_pd(a0, a1), w1));
+        }
+    }
+}
+
+static TARGET_AVX512 void stockham_4_avx512(const struct Complex* x, struct Complex* y, const int m, const int s,
+                                         const struct Complex* twiddles, const int inverse) {
+    for (int j = 0; j < m; j++) {
+        const __m512d w1 = _mm512_broadcast_f64x4(_mm256_broadcast_pd((const __m128d*) (twiddles + j * s)));
+        const __m512d w2 = _mm512_broadcast_f64x4(_mm256_broadcast_pd((const __m128d*) (twiddles + 2 * j * s)));
+        const __m512d w3 = _mm512_broadcast_f64x4(_mm256_broadcast_pd((const __m128d*) (twiddles + 3 * j * s)));
+        const double* x0 = (const double*) (x + s * j);
+        const double* x1 = (const double*) (x + s * (j + m));
+        const double* x2 = (const double*) (x + s * (j + 2 * m));
+        const double* x3 = (const double*) (x + s * (j + 3 * m));
+        double* y0 = (double*) (y + 4 * s * j);
+        double* y1 = y0 + 2 * s;
+        double* y2 = y0 + 4 * s;
+        double* y3 = y0 + 6 * s;
+        for (int q = 0; q < 2 * s; q += 8) {
+            const __m512d a0 = _mm512_loadu_pd(x0 + q);
+            const __m512d a1 = _mm512_loadu_pd(x1 + q);
+            const __m512d a2 = _mm512_loadu_pd(x2 + q);
+            const __m512d a3 = _mm512_loadu_pd(x3 + q);
+
+            const __m512d s0 = _mm512_add_pd(a0, a2);
+            const __m512d d0 = _mm512_sub_pd(a0, a2);
+            const __m512d s1 = _mm512_add_pd(a1, a3);
+            const __m512d r1 = rotate_avx512(_mm512_sub_pd(a1, a3), inverse);
+
+            _mm512_storeu_pd(y0 + q, _mm512_add_pd(s0, s1));
+            _mm512_storeu_pd(y1 + q, cmul_avx512(_mm512_add_pd(d0, r1), w1));
+            _mm512_storeu_pd(y2 + q, cmul_avx512(_mm512_sub_pd(s0, s1), w2));
+            _mm512_storeu_pd(y3 + q, cmul_avx512(_mm512_sub_pd(d0, r1), w3));
+        }
+    }
+}
+
+static TARGET_AVX512 void radix_2_stage_dif_avx512(struct Complex* X, const int N, const int half,
+                                                const struct Complex* w) {
+    for (int k = 0; k < N; k += 2 * half) {
+        double* a = (double*) (X + k);
+        double* b = (double*) (X + k + half);
+        for (int j = 0; j < 2 * half; j += 8) {
+            const __m512d u = _mm512_loadu_pd(a + j);
+            const __m512d v = _mm512_loadu_pd(b + j);
+            _mm512_storeu_pd(a + j, _mm512_add_pd(u, v));
+            _mm512_storeu_pd(b + j, cmul_avx512(_mm512_sub_pd(u, v), _mm512_loadu_pd((const double*) w + j)));
+        }
+    }
+}
+
+static TARGET_AVX512 void radix_4_stage_dif_avx512(struct Complex* X, const int N, const int h, const struct Complex* w,
+                                                const int inverse) {
+    const double* w1 = (const double*) w;
+    const double* w2 = (const double*) (w + h);
+    const double* w3 = (const double*) (w + 2 * h);
+    for (int k = 0; k < N; k += 4 * h) {
+        double* x0 = (double*) (X + k);
+        double* x1 = (double*) (X + k + h);
+        double* x2 = (double*) (X + k + 2 * h);
+        double* x3 = (double*) (X + k + 3 * h);
+        for (int j = 0; j < 2 * h; j += 8) {
+            const __m512d a0 = _mm512_loadu_pd(x0 + j);
+            const __m512d a1 = _mm512_loadu_pd(x1 + j);
+            const __m512d a2 = _mm512_loadu_pd(x2 + j);
+            const __m512d a3 = _mm512_loadu_pd(x3 + j);
+
+            const __m512d s0 = _mm512_add_pd(a0, a2);
+            const __m512d d0 = _mm512_sub_pd(a0, a2);
+            const __m512d s1 = _mm512_add_pd(a1, a3);
+            const __m512d r1 = rotate_avx512(_mm512_sub_pd(a1, a3), inverse);
+
+            _mm512_storeu_pd(x0 + j, _mm512_add_pd(s0, s1));
+            _mm512_storeu_pd(x1 + j, cmul_avx512(_mm512_sub_pd(s0, s1), _mm512_loadu_pd(w1 + j)));
+            _mm512_storeu_pd(x2 + j, cmul_avx512(_mm512_add_pd(d0, r1), _mm512_loadu_pd(w2 + j)));
+            _mm512_storeu_pd(x3 + j, cmul_avx512(_mm512_sub_pd(d0, r1), _mm512_loadu_pd(w3 + j)));
+        }
+    }
+}
+
+/*
+ * Split-complex kernels: no lane shuffles, a complex multiply is two FMAs and
+ * two multiplies. The SSE2 first-stage kernels (span 1, unit twiddles) work on
+ * two butterflies at a time, transposed in registers.
+ */
+static inline TARGET_SSE2 void cmul_split_sse2(const double* x_re, const double* x_im, const double* w_re,
+                                               const double* w_im, __m128d* t_re, __m128d* t_im) {
+    const __m128d xr = _mm_loadu_pd(x_re);
+    const __m128d xi = _mm_loadu_pd(x_im);
+    const __m128d wr = _mm_loadu_pd(w_re);
+    const __m128d wi = _mm_loadu_pd(w_im);
+    *t_re = _mm_sub_pd(_mm_mul_pd(xr, wr), _mm_mul_pd(xi, wi));
+    *t_im = _mm_add_pd(_mm_mul_pd(xr, wi), _mm_mul_pd(xi, wr));
+}
+
+static TARGET_SSE2 void radix_2_stage_split_sse2(double* re, double* im, const int N, const int half,
+                                                 const double* w_re, const double* w_im) {
+    for (int k = 0; k < N; k += 2 * half) {
+        for (int j = 0; j < half; j += 2) {
+            const int a = k + j;
+            const int b = k + j + half;
+            __m128d t_re, t_im;
+            cmul_split_sse2(re + b, im + b, w_re + j, w_im + j, &t_re, &t_im);
+            const __m128d u_re = _mm_loadu_pd(re + a);
+            const __m128d u_im = _mm_loadu_pd(im + a);
+            _mm_storeu_pd(re + a, _mm_add_pd(u_re, t_re));
+            _mm_storeu_pd(im + a, _mm_add_pd(u_im, t_im));
+            _mm_storeu_pd(re + b, _mm_sub_pd(u_re, t_re));
+            _mm_storeu_pd(im + b, _mm_sub_pd(u_im, t_im));
+        }
+    }
+}
+
+/* Span 1: pairs (x[k], x[k + 1]); two pairs per iteration, split into even / odd lanes. */
+static TARGET_SSE2 void radix_2_first_stage_split_sse2(double* re, double* im, const int N) {
+    double* parts[2] = {re, im};
+    for (int p = 0; p < 2; p++) {
+        double* x = parts[p];
+        for (int k = 0; k < N; k += 4) {
+            const __m128d v0 = _mm_loadu_pd(x + k);
+            const __m128d v1 = _mm_loadu_pd(x + k + 2);
+            const __m128d even = _mm_unpacklo_pd(v0, v1);
+            const __m128d odd = _mm_unpackhi_pd(v0, v1);
+            const __m128d sum = _mm_add_pd(even, odd);
+            const __m128d diff = _mm_sub_pd(even, odd);
+            _mm_storeu_pd(x + k, _mm_unpacklo_pd(sum, diff));
+            _mm_storeu_pd(x + k + 2, _mm_unpackhi_pd(sum, diff));
+        }
+    }
+}
+
+static TARGET_SSE2 void radix_4_stage_split_sse2(double* re, double* im, const int N, const int h,
+                                                 const double* w_re, const double* w_im, const int inverse) {
+    for (int k = 0; k < N; k += 4 * h) {
+        for (int j = 0; j < h; j += 2) {
+            const int i0 = k + j;
+            __m128d t1_re, t1_im, t2_re, t2_im, t3_re, t3_im;
+            cmul_split_sse2(re + i0 + h, im + i0 + h, w_re + j, w_im + j, &t1_re, &t1_im);
+            cmul_split_sse2(re + i0 + 2 * h, im + i0 + 2 * h, w_re + h + j, w_im + h + j, &t2_re, &t2_im);
+            cmul_split_sse2(re + i0 + 3 * h, im + i0 + 3 * h, w_re + 2 * h + j, w_im + 2 * h + j, &t3_re, &t3_im);
+            const __m128d a_re = _mm_loadu_pd(re + i0);
+            const __m128d a_im = _mm_loadu_pd(im + i0);
+            const __m128d s0_re = _mm_add_pd(a_re, t1_re), s0_im = _mm_add_pd(a_im, t1_im);
+            const __m128d d0_re = _mm_sub_pd(a_re, t1_re), d0_im = _mm_sub_pd(a_im, t1_im);
+            const __m128d s1_re = _mm_add_pd(t2_re, t3_re), s1_im = _mm_add_pd(t2_im, t3_im);
+            const __m128d d1_re = _mm_sub_pd(t2_re, t3_re), d1_im = _mm_sub_pd(t2_im, t3_im);
+            /* d0 + d1*-i and d0 - d1*-i; the inverse swaps legs 1 and 3 */
+            const __m128d p_re = _mm_add_pd(d0_re, d1_im), p_im = _mm_sub_pd(d0_im, d1_re);
+            const __m128d m_re = _mm_sub_pd(d0_re, d1_im), m_im = _mm_add_pd(d0_im, d1_re);
+
+            _mm_storeu_pd(re + i0, _mm_add_pd(s0_re, s1_re));
+            _mm_storeu_pd(im + i0, _mm_add_pd(s0_im, s1_im));
+            _mm_storeu_pd(re + i0 + 2 * h, _mm_sub_pd(s0_re, s1_re));
+            _mm_storeu_pd(im + i0 + 2 * h, _mm_sub_pd(s0_im, s1_im));
+            _mm_storeu_pd(re + i0 + h, inverse ? m_re : p_re);
+            _mm_storeu_pd(im + i0 + h, inverse ? m_im : p_im);
+            _mm_storeu_pd(re + i0 + 3 * h, inverse ? p_re : m_re);
+            _mm_storeu_pd(im + i0 + 3 * h, inverse ? p_im : m_im);
+        }
+    }
+}
+
+/* Span 1: 4-point DFTs of x[k..k+3] and x[k+4..k+7], one per lane after a 2x2 transpose of each leg pair. */
+static TARGET_SSE2 void radix_4_first_stage_split_sse2(double* re, double* im, const int N, const int inverse) {
+    for (int k = 0; k < N; k += 8) {
+        const __m128d r01 = _mm_loadu_pd(re + k), r23 = _mm_loadu_pd(re + k + 2);
+        const __m128d r45 = _mm_loadu_pd(re + k + 4), r67 = _mm_loadu_pd(re + k + 6);
+        const __m128d i01 = _mm_loadu_pd(im + k), i23 = _mm_loadu_pd(im + k + 2);
+        const __m128d i45 = _mm_loadu_pd(im + k + 4), i67 = _mm_loadu_pd(im + k + 6);
+        const __m128d a_re = _mm_unpacklo_pd(r01, r45), a_im = _mm_unpacklo_pd(i01, i45);
+        const __m128d b_re = _mm_unpackhi_pd(r01, r45), b_im = _mm_unpackhi_pd(i01, i45);
+        const __m128d c_re = _mm_unpacklo_pd(r23, r67), c_im = _mm_unpacklo_pd(i23, i67);
+        const __m128d d_re = _mm_unpackhi_pd(r23, r67), d_im = _mm_unpackhi_pd(i23, i67);
+
+        const __m128d s0_re = _mm_add_pd(a_re, b_re), s0_im = _mm_add_pd(a_im, b_im);
+        const __m128d d0_re = _mm_sub_pd(a_re, b_re), d0_im = _mm_sub_pd(a_im, b_im);
+        const __m128d s1_re = _mm_add_pd(c_re, d_re), s1_im = _mm_add_pd(c_im, d_im);
+        const __m128d d1_re = _mm_sub_pd(c_re, d_re), d1_im = _mm_sub_pd(c_im, d_im);
+        const __m128d p_re = _mm_add_pd(d0_re, d1_im), p_im = _mm_sub_pd(d0_im, d1_re);
+        const __m128d m_re = _mm_sub_pd(d0_re, d1_im), m_im = _mm_add_pd(d0_im, d1_re);
+
+        const __m128d y0_re = _mm_add_pd(s0_re, s1_re), y0_im = _mm_add_pd(s0_im, s1_im);
+        const __m128d y2_re = _mm_sub_pd(s0_re, s1_re), y2_im = _mm_sub_pd(s0_im, s1_im);
+        const __m128d y1_re = inverse ? m_re : p_re, y1_im = inverse ? m_im : p_im;
+        const __m128d y3_re = inverse ? p_re : m_re, y3_im = inverse ? p_im : m_im;
+
+        _mm_storeu_pd(re + k, _mm_unpacklo_pd(y0_re, y1_re));
+        _mm_storeu_pd(re + k + 2, _mm_unpacklo_pd(y2_re, y3_re));
+        _mm_storeu_pd(re + k + 4, _mm_unpackhi_pd(y0_re, y1_re));
+        _mm_storeu_pd(re + k + 6, _mm_unpackhi_pd(y2_re, y3_re));
+        _mm_storeu_pd(im + k, _mm_unpacklo_pd(y0_im, y1_im));
+        _mm_storeu_pd(im + k + 2, _mm_unpacklo_pd(y2_im, y3_im));
+        _mm_storeu_pd(im + k + 4, _mm_unpackhi_pd(y0_im, y1_im));
+        _mm_storeu_pd(im + k + 6, _mm_unpackhi_pd(y2_im, y3_im));
+    }
+}
+
+/* (x_re + i*x_im) * (w_re + i*w_im) for one vector of split elements. */
+static inline TARGET_AVX2 void cmul_split_avx2(const double* x_re, const double* x_im, const double* w_re,
+                                               const double* w_im, __m256d* t_re, __m256d* t_im) {
+    const __m256d xr = _mm256_loadu_pd(x_re);
+    const __m256d xi = _mm256_loadu_pd(x_im);
+    const __m256d wr = _mm256_loadu_pd(w_re);
+    const __m256d wi = _mm256_loadu_pd(w_im);
+    *t_re = _mm256_fmsub_pd(xr, wr, _mm256_mul_pd(xi, wi));
+    *t_im = _mm256_fmadd_pd(xr, wi, _mm256_mul_pd(xi, wr));
+}
+
+static TARGET_AVX2 void radix_2_stage_split_avx2(double* re, double* im, const int N, const int half,
+                                                 const double* w_re, const double* w_im) {
+    for (int k = 0; k < N; k += 2 * half) {
+        for (int j = 0; j < half; j += 4) {
+            const int a = k + j;
+            const int b = k + j + half;
+            __m256d t_re, t_im;
+            cmul_split_avx2(re + b, im + b, w_re + j, w_im + j, &t_re, &t_im);
+            const __m256d u_re = _mm256_loadu_pd(re + a);
+            const __m256d u_im = _mm256_loadu_pd(im + a);
+            _mm256_storeu_pd(re + a, _mm256_add_pd(u_re, t_re));
+            _mm256_storeu_pd(im + a, _mm256_add_pd(u_im, t_im));
+            _mm256_storeu_pd(re + b, _mm256_sub_pd(u_re, t_re));
+            _mm256_storeu_pd(im + b, _mm256_sub_pd(u_im, t_im));
+        }
+    }
+}
+
+static TARGET_AVX2 void radix_4_stage_split_avx2(double* re, double* im, const int N, const int h,
+                                                 const double* w_re, const double* w_im, const int inverse) {
+    for (int k = 0; k < N; k += 4 * h) {
+        for (int j = 0; j < h; j += 4) {
+            const int i0 = k + j;
+            __m256d t1_re, t1_im, t2_re, t2_im, t3_re, t3_im;
+            cmul_split_avx2(re + i0 + h, im + i0 + h, w_re + j, w_im + j, &t1_re, &t1_im);
+            cmul_split_avx2(re + i0 + 2 * h, im + i0 + 2 * h, w_re + h + j, w_im + h + j, &t2_re, &t2_im);
+            cmul_split_avx2(re + i0 + 3 * h, im + i0 + 3 * h, w_re + 2 * h + j, w_im + 2 * h + j, &t3_re, &t3_im);
+            const __m256d a_re = _mm256_loadu_pd(re + i0);
+            const __m256d a_im = _mm256_loadu_pd(im + i0);
+            const __m256d s0_re = _mm256_add_pd(a_re, t1_re), s0_im = _mm256_add_pd(a_im, t1_im);
+            const __m256d d0_re = _mm256_sub_pd(a_re, t1_re), d0_im = _mm256_sub_pd(a_im, t1_im);
+            const __m256d s1_re = _mm256_add_pd(t2_re, t3_re), s1_im = _mm256_add_pd(t2_im, t3_im);
+            const __m256d d1_re = _mm256_sub_pd(t2_re, t3_re), d1_im = _mm256_sub_pd(t2_im, t3_im);
+            /* d0 + d1*-i and d0 - d1*-i; the inverse swaps legs 1 and 3 */
+            const __m256d p_re = _mm256_add_pd(d0_re, d1_im), p_im = _mm256_sub_pd(d0_im, d1_re);
+            const __m256d m_re = _mm256_sub_pd(d0_re, d1_im), m_im = _mm256_add_pd(d0_im, d1_re);
+
+            _mm256_storeu_pd(re + i0, _mm256_add_pd(s0_re, s1_re));
+            _mm256_storeu_pd(im + i0, _mm256_add_pd(s0_im, s1_im));
+            _mm256_storeu_pd(re + i0 + 2 * h, _mm256_sub_pd(s0_re, s1_re));
+            _mm256_storeu_pd(im + i0 + 2 * h, _mm256_sub_pd(s0_im, s1_im));
+            _mm256_storeu_pd(re + i0 + h, inverse ? m_re : p_re);
+            _mm256_storeu_pd(im + i0 + h, inverse ? m_im : p_im);
+            _mm256_storeu_pd(re + i0 + 3 * h, inverse ? p_re : m_re);
+            _mm256_storeu_pd(im + i0 + 3 * h, inverse ? p_im : m_im);
+        }
+    }
+}
+
+static inline TARGET_AVX512 void cmul_split_avx512(const double* x_re, const double* x_im, const double* w_re,
+                                                   const double* w_im, __m512d* t_re, __m512d* t_im) {
+    const __m512d xr = _mm512_loadu_pd(x_re);
+    const __m512d xi = _mm512_loadu_pd(x_im);
+    const __m512d wr = _mm512_loadu_pd(w_re);
+    const __m512d wi = _mm512_loadu_pd(w_im);
+    *t_re = _mm512_fmsub_pd(xr, wr, _mm512_mul_pd(xi, wi));
+    *t_im = _mm512_fmadd_pd(xr, wi, _mm512_mul_pd(xi, wr));
+}
+
+static TARGET_AVX512 void radix_2_stage_split_avx512(double* re, double* im, const int N, const int half,
+                                                     const double* w_re, const double* w_im) {
+    for (int k = 0; k < N; k += 2 * half) {
+        for (int j = 0; j < half; j += 8) {
+            const int a = k + j;
+            const int b = k + j + half;
+            __m512d t_re, t_im;
+            cmul_split_avx512(re + b, im + b, w_re + j, w_im + j, &t_re, &t_im);
+            const __m512d u_re = _mm512_loadu_pd(re + a);
+            const __m512d u_im = _mm512_loadu_pd(im + a);
+            _mm512_storeu_pd(re + a, _mm512_add_pd(u_re, t_re));
+            _mm512_storeu_pd(im + a, _mm512_add_pd(u_im, t_im));
+            _mm512_storeu_pd(re + b, _mm512_sub_pd(u_re, t_re));
+            _mm512_storeu_pd(im + b, _mm512_sub_pd(u_im, t_im));
+        }
+    }
+}
+
+static TARGET_AVX512 void radix_4_stage_split_avx512(double* re, double* im, const int N, const int h,
+                                                     const double* w_re, const double* w_im, const int inverse) {
+    for (int k = 0; k < N; k += 4 * h) {
+        for (int j = 0; j < h; j += 8) {
+            const int i0 = k + j;
+            __m512d t1_re, t1_im, t2_re, t2_im, t3_re, t3_im;
+            cmul_split_avx512(re + i0 + h, im + i0 + h, w_re + j, w_im + j, &t1_re, &t1_im);
+            cmul_split_avx512(re + i0 + 2 * h, im + i0 + 2 * h, w_re + h + j, w_im + h + j, &t2_re, &t2_im);
+            cmul_split_avx512(re + i0 + 3 * h, im + i0 + 3 * h, w_re + 2 * h + j, w_im + 2 * h + j, &t3_re, &t3_im);
+            const __m512d a_re = _mm512_loadu_pd(re + i0);
+            const __m512d a_im = _mm512_loadu_pd(im + i0);
+            const __m512d s0_re = _mm512_add_pd(a_re, t1_re), s0_im = _mm512_add_pd(a_im, t1_im);
+            const __m512d d0_re = _mm512_sub_pd(a_re, t1_re), d0_im = _mm512_sub_pd(a_im, t1_im);
+            const __m512d s1_re = _mm512_add_pd(t2_re, t3_re), s1_im = _mm512_add_pd(t2_im, t3_im);
+            const __m512d d1_re = _mm512_sub_pd(t2_re, t3_re), d1_im = _mm512_sub_pd(t2_im, t3_im);
+            const __m512d p_re = _mm512_add_pd(d0_re, d1_im), p_im = _mm512_sub_pd(d0_im, d1_re);
+            const __m512d m_re = _mm512_sub_pd(d0_re, d1_im), m_im = _mm512_add_pd(d0_im, d1_re);
+
+            _mm512_storeu_pd(re + i0, _mm512_add_pd(s0_re, s1_re));
+            _mm512_storeu_pd(im + i0, _mm512_add_pd(s0_im, s1_im));
+            _mm512_storeu_pd(re + i0 + 2 * h, _mm512_sub_pd(s0_re, s1_re));
+            _mm512_storeu_pd(im + i0 + 2 * h, _mm512_sub_pd(s0_im, s1_im));
+            _mm512_storeu_pd(re + i0 + h, inverse ? m_re : p_re);
+            _mm512_storeu_pd(im + i0 + h, inverse ? m_im : p_im);
+            _mm512_storeu_pd(re + i0 + 3 * h, inverse ? p_re : m_re);
+            _mm512_storeu_pd(im + i0 + 3 * h, inverse ? p_im : m_im);
+        }
+    }
+}
+
+/*
+ * Single precision on interleaved struct ComplexF: the double kernels above with
+ * two, four and eight complex per vector.
+ */
+static inline TARGET_SSE2 __m128 cmulf_sse2(const __m128 a, const __m128 w) {
+    const __m128 w_re = _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 0, 0));
+    const __m128 w_im = _mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 1, 1));
+    const __m128 a_swap = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_add_ps(_mm_mul_ps(a, w_re), _mm_xor_ps(_mm_mul_ps(a_swap, w_im), _mm_set_ps(0.0f, -0.0f, 0.0f, -0.0f)));
+}
+
+static inline TARGET_SSE2 __m128 rotatef_sse2(const __m128 d, const int inverse) {
+    const __m128 d_swap = _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_xor_ps(d_swap, inverse ? _mm_set_ps(0.0f, -0.0f, 0.0f, -0.0f) : _mm_set_ps(-0.0f, 0.0f, -0.0f, 0.0f));
+}
+
+static TARGET_SSE2 void radix_2_stagef_sse2(struct ComplexF* X, const int N, const int half,
+                                            const struct ComplexF* w) {
+    for (int k = 0; k < N; k += 2 * half) {
+        float* a = (float*) (X + k);
+        float* b = (float*) (X + k + half);
+        for (int j = 0; j < 2 * half; j += 4) {
+            const __m128 u = _mm_loadu_ps(a + j);
+            const __m128 t = cmulf_sse2(_mm_loadu_ps(b + j), _mm_loadu_ps((const float*) w + j));
+            _mm_storeu_ps(a + j, _mm_add_ps(u, t));
+            _mm_storeu_ps(b + j, _mm_sub_ps(u, t));
+        }
+    }
+}
+
+static TARGET_SSE2 void radix_4_stagef_sse2(struct ComplexF* X, const int N, const int h, const struct ComplexF* w,
+                                            const int inverse) {
+    const float* w1 = (const float*) w;
+    const float* w2 = (const float*) (w + h);
+    const float* w3 = (const float*) (w + 2 * h);
+    for (int k = 0; k < N; k += 4 * h) {
+        float* x0 = (float*) (X + k);
+        float* x1 = (float*) (X + k + h);
+        float* x2 = (float*) (X + k + 2 * h);
+        float* x3 = (float*) (X + k + 3 * h);
+        for (int j = 0; j < 2 * h; j += 4) {
+            const __m128 a0 = _mm_loadu_ps(x0 + j);
+            const __m128 t1 = cmulf_sse2(_mm_loadu_ps(x1 + j), _mm_loadu_ps(w1 + j));
+            const __m128 t2 = cmulf_sse2(_mm_loadu_ps(x2 + j), _mm_loadu_ps(w2 + j));
+            const __m128 t3 = cmulf_sse2(_mm_loadu_ps(x3 + j), _mm_loadu_ps(w3 + j));
+
+            const __m128 s0 = _mm_add_ps(a0, t1);
+            const __m128 d0 = _mm_sub_ps(a0, t1);
+            const __m128 s1 = _mm_add_ps(t2, t3);
+            const __m128 r1 = rotatef_sse2(_mm_sub_ps(t2, t3), inverse);
+
+            _mm_storeu_ps(x0 + j, _mm_add_ps(s0, s1));
+            _mm_storeu_ps(x1 + j, _mm_add_ps(d0, r1));
+            _mm_storeu_ps(x2 + j, _mm_sub_ps(s0, s1));
+            _mm_storeu_ps(x3 + j, _mm_sub_ps(d0, r1));
+        }
+    }
+}
+
+static inline TARGET_AVX2 __m256 cmulf_avx2(const __m256 a, const __m256 w) {
+    const __m256 w_re = _mm256_moveldup_ps(w);
+    const __m256 w_im = _mm256_movehdup_ps(w);
+    const __m256 a_swap = _mm256_permute_ps(a, 0xB1);
+    return _mm256_fmaddsub_ps(a, w_re, _mm256_mul_ps(a_swap, w_im));
+}
+
+static inline TARGET_AVX2 __m256 rotatef_avx2(const __m256 d, const int inverse) {
+    const __m256 d_swap = _mm256_permute_ps(d, 0xB1);
+    return _mm256_xor_ps(d_swap, inverse ? _mm256_set_ps(0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f)
+                                         : _mm256_set_ps(-0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f, -0.0f, 0.0f));
+}
+
+static TARGET_AVX2 void radix_2_stagef_avx2(struct ComplexF* X, const int N, const int half,
+                                            const struct ComplexF* w) {
+    for (int k = 0; k < N; k += 2 * half) {
+        float* a = (float*) (X + k);
+        float* b = (float*) (X + k + half);
+        for (int j = 0; j < 2 * half; j += 8) {
+            const __m256 u = _mm256_loadu_ps(a + j);
+            const __m256 t = cmulf_avx2(_mm256_loadu_ps(b + j), _mm256_loadu_ps((const float*) w + j));
+            _mm256_storeu_ps(a + j, _mm256_add_ps(u, t));
+            _mm256_storeu_ps(b + j, _mm256_sub_ps(u, t));
+        }
+    }
+}
+
+static TARGET_AVX2 void radix_4_stagef_avx2(struct ComplexF* X, const int N, const int h, const struct ComplexF* w,
+                                            const int inverse) {
+    const float* w1 = (const float*) w;
+    const float* w2 = (const float*) (w + h);
+    const float* w3 = (const float*) (w + 2 * h);
+    for (int k = 0; k < N; k += 4 * h) {
+        float* x0 = (float*) (X + k);
+        float* x1 = (float*) (X + k + h);
+        float* x2 = (float*) (X + k + 2 * h);
+        float* x3 = (float*) (X + k + 3 * h);
+        for (int j = 0; j < 2 * h; j += 8) {
+            const __m256 a0 = _mm256_loadu_ps(x0 + j);
+            const __m256 t1 = cmulf_avx2(_mm256_loadu_ps(x1 + j), _mm256_loadu_ps(w1 + j));
+            const __m256 t2 = cmulf_avx2(_mm256_loadu_ps(x2 + j), _mm256_loadu_ps(w2 + j));
+            const __m256 t3 = cmulf_avx2(_mm256_loadu_ps(x3 + j), _mm256_loadu_ps(w3 + j));
+
+            const __m256 s0 = _mm256_add_ps(a0, t1);
+            const __m256 d0 = _mm256_sub_ps(a0, t1);
+            const __m256 s1 = _mm256_add_ps(t2, t3);
+            const __m256 r1 = rotatef_avx2(_mm256_sub_ps(t2, t3), inverse);
+
+            _mm256_storeu_ps(x0 + j, _mm256_add_ps(s0, s1));
+            _mm256_storeu_ps(x1 + j, _mm256_add_ps(d0, r1));
+            _mm256_storeu_ps(x2 + j, _mm256_sub_ps(s0, s1));
+            _mm256_storeu_ps(x3 + j, _mm256_sub_ps(d0, r1));
+        }
+    }
+}
+
+static inline TARGET_AVX512 __m512 cmulf_avx512(const __m512 a, const __m512 w) {
+    const __m512 w_re = _mm512_moveldup_ps(w);
+    const __m512 w_im = _mm512_movehdup_ps(w);
+    const __m512 a_swap = _mm512_permute_ps(a, 0xB1);
+    return _mm512_fmaddsub_ps(a, w_re, _mm512_mul_ps(a_swap, w_im));
+}
+
+static inline TARGET_AVX512 __m512 rotatef_avx512(const __m512 d, const int inverse) {
+    const __m512 d_swap = _mm512_permute_ps(d, 0xB1);
+    return _mm512_mask_sub_ps(d_swap, inverse ? 0x5555 : 0xAAAA, _mm512_setzero_ps(), d_swap);
+}
+
+static TARGET_AVX512 void radix_2_stagef_avx512(struct ComplexF* X, const int N, const int half,
+                                                const struct ComplexF* w) {
+    for (int k = 0; k < N; k += 2 * half) {
+        float* a = (float*) (X + k);
+        float* b = (float*) (X + k + half);
+        for (int j = 0; j < 2 * half; j += 16) {
+            const __m512 u = _mm512_loadu_ps(a + j);
+            const __m512 t = cmulf_avx512(_mm512_loadu_ps(b + j), _mm512_loadu_ps((const float*) w + j));
+            _mm512_storeu_ps(a + j, _mm512_add_ps(u, t));
+            _mm512_storeu_ps(b + j, _mm512_sub_ps(u, t));
+        }
+    }
+}
+
+static TARGET_AVX512 void radix_4_stagef_avx512(struct ComplexF* X, const int N, const int h,
+                                                const struct ComplexF* w, const int inverse) {
+    const float* w1 = (const float*) w;
+    const float* w2 = (const float*) (w + h);
+    const float* w3 = (const float*) (w + 2 * h);
+    for (int k = 0; k < N; k += 4 * h) {
+        float* x0 = (float*) (X + k);
+        float* x1 = (float*) (X + k + h);
+        float* x2 = (float*) (X + k + 2 * h);
+        float* x3 = (float*) (X + k + 3 * h);
+        for (int j = 0; j < 2 * h; j += 16) {
+            const __m512 a0 = _mm512_loadu_ps(x0 + j);
+            const __m512 t1 = cmulf_avx512(_mm512_loadu_ps(x1 + j), _mm512_loadu_ps(w1 + j));
+            const __m512 t2 = cmulf_avx512(_mm512_loadu_ps(x2 + j), _mm512_loadu_ps(w2 + j));
+            const __m512 t3 = cmulf_avx512(_mm512_loadu_ps(x3 + j), _mm512_loadu_ps(w3 + j));
+
+            const __m512 s0 = _mm512_add_ps(a0, t1);
+            const __m512 d0 = _mm512_sub_ps(a0, t1);
+            const __m512 s1 = _mm512_add_ps(t2, t3);
+            const __m512 r1 = rotatef_avx512(_mm512_sub_ps(t2, t3), inverse);
+
+            _mm512_storeu_ps(x0 + j, _mm512_add_ps(s0, s1));
+            _mm512_storeu_ps(x1 + j, _mm512_add_ps(d0, r1));
+            _mm512_storeu_ps(x2 + j, _mm512_sub_ps(s0, s1));
+            _mm512_storeu_ps(x3 + j, _mm512_sub_ps(d0, r1));
+        }
+    }
+}
+
+#endif
+
+/* Spans too short for a full vector drop to the next narrower level. */
+int simd_radix_2_stage(struct Complex* X, const int N, const int half, const struct Complex* w) {
+#if SIMD_X86
+    const enum SimdLevel level = simd_get_level();
+    if (level >= SIMD_AVX512 && half % 4 == 0) {
+        radix_2_stage_avx512(X, N, half, w);
+        return 1;
+    }
+    if (level >= SIMD_AVX2 && half % 2 == 0) {
+        radix_2_stage_avx2(X, N, half, w);
+        return 1;
+    }
+    if (level >= SIMD_SSE2) {
+        radix_2_stage_sse2(X, N, half, w);
+        return 1;
+    }
+#else
+    (void) X;
+    (void) N;
+    (void) half;
+    (void) w;
+#endif
+    return 0;
+}
+
+int simd_radix_4_stage(struct Complex* X, const int N, const int h, const struct Complex* w, const int inverse) {
+#if SIMD_X86
+    const enum SimdLevel level = simd_get_level();
+    if (level >= SIMD_AVX512 && h % 4 == 0) {
+        radix_4_stage_avx512(X, N, h, w, inverse);
+        return 1;
+    }
+    if (level >= SIMD_AVX2 && h % 2 == 0) {
+        radix_4_stage_avx2(X, N, h, w, inverse);
+        return 1;
+    }
+    if (level >= SIMD_SSE2) {
+        radix_4_stage_sse2(X, N, h, w, inverse);
+        return 1;
+    }
+#else
+    (void) X;
+    (void) N;
+    (void) h;
+    (void) w;
+    (void) inverse;
+#endif
+    return 0;
+}
+
+/* p is 2 or 4; spans s too short for a full vector drop to the next narrower level. */
+int simd_stockham_stage(const struct Complex* x, struct Complex* y, const int p, const int m, const int s,
+                        const struct Complex* twiddles, const int inverse) {
+#if SIMD_X86
+    const enum SimdLevel level = simd_get_level();
+    if (p != 2 && p != 4) {
+        return 0;
+    }
+    if (level >= SIMD_AVX512 && s % 4 == 0) {
+        if (p == 2) {
+            stockham_2_avx512(x, y, m, s, twiddles);
+        } else {
+            stockham_4_avx512(x, y, m, s, twiddles, inverse);
+        }
+        return 1;
+    }
+    if (level >= SIMD_AVX2 && s % 2 == 0) {
+        if (p == 2) {
+            stockham_2_avx2(x, y, m, s, twiddles);
+        } else {
+            stockham_4_avx2(x, y, m, s, twiddles, inverse);
+        }
+        return 1;
+    }
+    if (level >= SIMD_SSE2) {
+        if (p == 2) {
+            stockham_2_sse2(x, y, m, s, twiddles);
+        } else {
+            stockham_4_sse2(x, y, m, s, twiddles, inverse);
+        }
+        return 1;
+    }
+#else
+    (void) x;
+    (void) y;
+    (void) p;
+    (void) m;
+    (void) s;
+    (void) twiddles;
+    (void) inverse;
+#endif
+    return 0;
+}
+
+int simd_radix_2_stage_dif(struct Complex* X, const int N, const int half, const struct Complex* w) {
+#if SIMD_X86
+    const enum SimdLevel level = simd_get_level();
+    if (level >= SIMD_AVX512 && half % 4 == 0) {
+        radix_2_stage_dif_avx512(X, N, half, w);
+        return 1;
+    }
+    if (level >= SIMD_AVX2 && half % 2 == 0) {
+        radix_2_stage_dif_avx2(X, N, half, w);
+        return 1;
+    }
+    if (level >= SIMD_SSE2) {
+        radix_2_stage_dif_sse2(X, N, half, w);
+        return 1;
+    }
+#else
+    (void) X;
+    (void) N;
+    (void) half;
+    (void) w;
+#endif
+    return 0;
+}
+
+int simd_radix_4_stage_dif(struct Complex* X, const int N, const int h, const struct Complex* w, const int inverse) {
+#if SIMD_X86
+    const enum SimdLevel level = simd_get_level();
+    if (level >= SIMD_AVX512 && h % 4 == 0) {
+        radix_4_stage_dif_avx512(X, N, h, w, inverse);
+        return 1;
+    }
+    if (level >= SIMD_AVX2 && h % 2 == 0) {
+        radix_4_stage_dif_avx2(X, N, h, w, inverse);
+        return 1;
+    }
+    if (level >= SIMD_SSE2) {
+        radix_4_stage_dif_sse2(X, N, h, w, inverse);
+        return 1;
+    }
+#else
+    (void) X;
+    (void) N;
+    (void) h;
+    (void) w;
+    (void) inverse;
+#endif
+    return 0;
+}
+
+int simd_radix_2_stage_split(double* re, double* im, const int N, const int half, const double* w_re,
+                             const double* w_im) {
+#if SIMD_X86
+    const enum SimdLevel level = simd_get_level();
+    if (level >= SIMD_AVX512 && half % 8 == 0) {
+        radix_2_stage_split_avx512(re, im, N, half, w_re, w_im);
+        return 1;
+    }
+    if (level >= SIMD_AVX2 && half % 4 == 0) {
+        radix_2_stage_split_avx2(re, im, N, half, w_re, w_im);
+        return 1;
+    }
+    if (level >= SIMD_SSE2 && half % 2 == 0) {
+        radix_2_stage_split_sse2(re, im, N, half, w_re, w_im);
+        return 1;
+    }
+    if (level >= SIMD_SSE2 && half == 1 && N % 4 == 0) {
+        radix_2_first_stage_split_sse2(re, im, N);
+        return 1;
+    }
+#else
+    (void) re;
+    (void) im;
+    (void) N;
+    (void) half;
+    (void) w_re;
+    (void) w_im;
+#endif
+    return 0;
+}
+
+int simd_radix_4_stage_split(double* re, double* im, const int N, const int h, const double* w_re,
+                             const double* w_im, const int inverse) {
+#if SIMD_X86
+    const enum SimdLevel level = simd_get_level();
+    if (level >= SIMD_AVX512 && h % 8 == 0) {
+        radix_4_stage_split_avx512(re, im, N, h, w_re, w_im, inverse);
+        return 1;
+    }
+    if (level >= SIMD_AVX2 && h % 4 == 0) {
+        radix_4_stage_split_avx2(re, im, N, h, w_re, w_im, inverse);
+        return 1;
+    }
+    if (level >= SIMD_SSE2 && h % 2 == 0) {
+        radix_4_stage_split_sse2(re, im, N, h, w_re, w_im, inverse);
+        return 1;
+    }
+    if (level >= SIMD_SSE2 && h == 1 && N % 8 == 0) {
+        radix_4_first_stage_split_sse2(re, im, N, inverse);
+        return 1;
+    }
+#else
+    (void) re;
+    (void) im;
+    (void) N;
+    (void) h;
+    (void) w_re;
+    (void) w_im;
+    (void) inverse;
+#endif
+    return 0;
+}
+
+int simd_radix_2_stagef(struct ComplexF* X, const int N, const int half, const struct ComplexF* w) {
+#if SIMD_X86
+    const enum SimdLevel level = simd_get_level();
+    if (level >= SIMD_AVX512 && half % 8 == 0) {
+        radix_2_stagef_avx512(X, N, half, w);
+        return 1;
+    }
+    if (level >= SIMD_AVX2 && half % 4 == 0) {
+        radix_2_stagef_avx2(X, N, half, w);
+        return 1;
+    }
+    if (level >= SIMD_SSE2 && half % 2 == 0) {
+        radix_2_stagef_sse2(X, N, half, w);
+        return 1;
+    }
+#else
+    (void) X;
+    (void) N;
+    (void) half;
+    (void) w;
+#endif
+    return 0;
+}
+
+int simd_radix_4_stagef(struct ComplexF* X, const int N, const int h, const struct ComplexF* w, const int inverse) {
+#if SIMD_X86
+    const enum SimdLevel level = simd_get_level();
+    if (level >= SIMD_AVX512 && h % 8 == 0) {
+        radix_4_stagef_avx512(X, N, h, w, inverse);
+        return 1;
+    }
+    if (level >= SIMD_AVX2 && h % 4 == 0) {
+        radix_4_stagef_avx2(X, N, h, w, inverse);
+        return 1;
+    }
+    if (level >= SIMD_SSE2 && h % 2 == 0) {
+        radix_4_stagef_sse2(X, N, h, w, inverse);
+        return 1;
+    }
+#else
+    (void) X;
+    (void) N;
+    (void) h;
+    (void) w;
+    (void) inverse;
+#endif
+    return 0;
+}
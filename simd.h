@@ -0,0 +1,70 @@
+#ifndef SIMD_H
+#define SIMD_H
+#include "complex.h"
+#include "complexf.h"
+
+/*
+ * SIMD BUTTERFLIES
+ * Vectorized radix-2 / radix-4 stages for power-of-two plans, on interleaved
+ * struct Complex data. The instruction set is picked at run time from CPUID,
+ * so one binary uses AVX-512 or AVX2 where available and SSE2 elsewhere.
+ */
+enum SimdLevel {
+    SIMD_SCALAR,    /* complex.c arithmetic, the reference path */
+    SIMD_SSE2,      /* one complex per vector */
+    SIMD_AVX2,      /* two per vector, with FMA */
+    SIMD_AVX512     /* four per vector */
+};
+
+/* Best level this CPU supports. */
+enum SimdLevel simd_detect(void);
+
+/* Caps the level used from now on (e.g. SIMD_SCALAR to compare against the reference); clamped to simd_detect(). */
+void simd_set_level(enum SimdLevel level);
+
+enum SimdLevel simd_get_level(void);
+
+const char* simd_level_name(enum SimdLevel level);
+
+/*
+ * One radix-2 stage of span half over X[0..N): w[j] multiplies X[k + j + half].
+ * Returns 0 without touching X if no SIMD level applies; the caller then runs the scalar stage.
+ */
+int simd_radix_2_stage(struct Complex* X, int N, int half, const struct Complex* w);
+
+/*
+ * One fused radix-4 stage of span h, as radix_4_stage in plan.c: w holds h
+ * twiddles for each of X[k + j + h], X[k + j + 2h] and X[k + j + 3h], in that order.
+ */
+int simd_radix_4_stage(struct Complex* X, int N, int h, const struct Complex* w, int inverse);
+
+/*
+ * One Stockham autosort pass of radix p (2 or 4) from x into y, as stockham_stage
+ * in plan.c: n = p * m points at stride s, twiddles holding exp(-+2*pi*i*k/N).
+ */
+int simd_stockham_stage(const struct Complex* x, struct Complex* y, int p, int m, int s,
+                        const struct Complex* twiddles, int inverse);
+
+/* Decimation-in-frequency counterparts of the stages above: same twiddles, applied after the butterfly. */
+int simd_radix_2_stage_dif(struct Complex* X, int N, int half, const struct Complex* w);
+
+int simd_radix_4_stage_dif(struct Complex* X, int N, int h, const struct Complex* w, int inverse);
+
+/*
+ * Split-complex stages: separate real / imaginary arrays and twiddles, so a
+ * complex multiply needs no lane shuffles. Same contract as above.
+ */
+int simd_radix_2_stage_split(double* re, double* im, int N, int half, const double* w_re, const double* w_im);
+
+int simd_radix_4_stage_split(double* re, double* im, int N, int h, const double* w_re, const double* w_im,
+                             int inverse);
+
+/*
+ * Single-precision stages on interleaved struct ComplexF, as simd_radix_2_stage /
+ * simd_radix_4_stage: a vector holds twice as many complex, so each level needs twice the span.
+ */
+int simd_radix_2_stagef(struct ComplexF* X, int N, int half, const struct ComplexF* w);
+
+int simd_radix_4_stagef(struct ComplexF* X, int N, int h, const struct ComplexF* w, int inverse);
+
+#endif //SIMD_H
@@ -0,0 +1,297 @@
+#include "stft.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+#include "complex.h"
+#include "plan.h"
+#include "planner.h"
+#include "rfft.h"
+#include "threads.h"
+#include "util.h"
+
+/* Output samples per task in the overlap-add pass. */
+#define STFT_OLA_BLOCK 4096
+
+/* Modified Bessel function of the first kind, order 0, by its power series. */
+static double bessel_i0(const double x) {
+    double sum = 1;
+    double term = 1;
+    for (int k = 1; k < 500 && term > 1e-17 * sum; k++) {
+        term *= (x / (2 * k)) * (x / (2 * k));
+        sum += term;
+    }
+    return sum;
+}
+
+double* stft_window(const enum WindowType type, const int N, const double beta) {
+    double* w = malloc(N * sizeof(double));
+    if (w == NULL) {
+        fprintf(stderr, "stft_window failed\n");
+        return NULL;
+    }
+    for (int n = 0; n < N; n++) {
+        const double phase = 2.0 * M_PI * n / N;
+        switch (type) {
+            case WINDOW_HANN:
+                w[n] = 0.5 - 0.5 * cos(phase);
+                break;
+            case WINDOW_HAMMING:
+                w[n] = 0.54 - 0.46 * cos(phase);
+                break;
+            case WINDOW_BLACKMAN:
+                w[n] = 0.42 - 0.5 * cos(phase) + 0.08 * cos(2 * phase);
+                break;
+            case WINDOW_KAISER: {
+                const double r = 2.0 * n / N - 1;
+                w[n] = bessel_i0(beta * sqrt(1 - r * r)) / bessel_i0(beta);
+                break;
+            }
+            default:
+                w[n] = 1;
+                break;
+        }
+    }
+    return w;
+}
+
+struct STFTPlan* stft_plan_create(const int N, const int hop, const enum WindowType window, const double beta) {
+    if (N < 1 || hop < 1 || hop > N) {
+        fprintf(stderr, "stft_plan_create: invalid N=%d hop=%d\n", N, hop);
+        return NULL;
+    }
+    struct STFTPlan* plan = calloc(1, sizeof(struct STFTPlan));
+    if (plan == NULL) {
+        fprintf(stderr, "stft_plan_create failed\n");
+        return NULL;
+    }
+    plan->N = N;
+    plan->hop = hop;
+    plan->window = stft_window(window, N, beta);
+    plan->rforward = rfft_plan_create(N, 0);
+    plan->rbackward = rfft_plan_create(N, 1);
+    plan->forward = fft_plan_get(N, 0);
+    plan->backward = fft_plan_get(N, 1);
+    if (plan->window == NULL || plan->rforward == NULL || plan->rbackward == NULL || plan->forward == NULL ||
+        plan->backward == NULL) {
+        stft_plan_destroy(plan);
+        return NULL;
+    }
+    return plan;
+}
+
+void stft_plan_destroy(struct STFTPlan* plan) {
+    if (plan == NULL) {
+        return;
+    }
+    free(plan->window);
+    rfft_plan_destroy(plan->rforward);
+    rfft_plan_destroy(plan->rbackward);
+    free(plan);
+}
+
+/* The last frame must reach sample len - 1; frame t ends at t * hop + N - N / 2 - 1. */
+int stft_frame_count(const struct STFTPlan* plan, const int len) {
+    const int reach = plan->N - plan->N / 2;
+    return len <= reach ? 1 : 1 + (len - reach + plan->hop - 1) / plan->hop;
+}
+
+/* One of x_real / x is set for the forward pass; one of y_real / y for the inverse. */
+struct STFTPass {
+    const struct STFTPlan* plan;
+    int len;
+    const double* x_real;
+    const struct Complex* x;
+    struct Complex2D* X;
+    const struct Complex2D* X_in;
+    double* frames_real;        /* inverse: frames x N windowed time samples */
+    struct Complex* frames;
+    double* y_real;
+    struct Complex* y;
+};
+
+static int stft_work_size(const struct STFTPlan* plan) {
+    const int work_r = rfft_plan_work_size(plan->rforward) > rfft_plan_work_size(plan->rbackward)
+                       ? rfft_plan_work_size(plan->rforward) : rfft_plan_work_size(plan->rbackward);
+    const int work_c = fft_plan_work_size(plan->forward) > fft_plan_work_size(plan->backward)
+                       ? fft_plan_work_size(plan->forward) : fft_plan_work_size(plan->backward);
+    return (work_r > work_c ? work_r : work_c) + 1;
+}
+
+static void stft_frames_range(void* ctx, const int begin, const int end, const int thread) {
+    (void) thread;
+    const struct STFTPass* pass = ctx;
+    const struct STFTPlan* plan = pass->plan;
+    const int N = plan->N;
+    const double* w = plan->window;
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct Complex* frame = fft_arena_cplx_arr(arena, N);
+    struct Complex* work = fft_arena_cplx_arr(arena, stft_work_size(plan));
+    if (frame == NULL || work == NULL) {
+        fft_arena_release(arena, mark);
+        return;
+    }
+    /* Real frames use the first N / 2 complex slots as N doubles. */
+    double* frame_real = (double*) frame;
+
+    for (int t = begin; t < end; t++) {
+        const int start = t * plan->hop - N / 2;
+        const int n_begin = start < 0 ? -start : 0;
+        const int n_end = start + N > pass->len ? pass->len - start : N;
+        if (pass->x_real != NULL) {
+            memset(frame_real, 0, N * sizeof(double));
+            for (int n = n_begin; n < n_end; n++) {
+                frame_real[n] = pass->x_real[start + n] * w[n];
+            }
+            rfft_plan_execute_r2c(plan->rforward, frame_real, cplx_2d_row(pass->X, t), work);
+        } else {
+            memset(frame, 0, N * sizeof(struct Complex));
+            for (int n = n_begin; n < n_end; n++) {
+                frame[n] = (struct Complex){pass->x[start + n].real * w[n], pass->x[start + n].imag * w[n]};
+            }
+            fft_plan_execute_work(plan->forward, frame, cplx_2d_row(pass->X, t), work);
+        }
+    }
+    fft_arena_release(arena, mark);
+}
+
+static struct Complex2D* stft_forward(const struct STFTPlan* plan, const double* x_real, const struct Complex* x,
+                                      const int len) {
+    const int frames = stft_frame_count(plan, len);
+    struct Complex2D* X = malloc_2d_cplx_arr(frames, x_real != NULL ? plan->N / 2 + 1 : plan->N);
+    if (X == NULL) {
+        return NULL;
+    }
+    struct STFTPass pass = {plan, len, x_real, x, X, NULL, NULL, NULL, NULL, NULL};
+    parallel_for(frames, 1, stft_frames_range, &pass);
+    return X;
+}
+
+struct Complex2D* stft_real(const struct STFTPlan* plan, const double* x, const int len) {
+    return stft_forward(plan, x, NULL, len);
+}
+
+struct Complex2D* stft(const struct STFTPlan* plan, const struct Complex* x, const int len) {
+    return stft_forward(plan, NULL, x, len);
+}
+
+/* Inverse transforms each frame and applies the synthesis window. */
+static void istft_frames_range(void* ctx, const int begin, const int end, const int thread) {
+    (void) thread;
+    const struct STFTPass* pass = ctx;
+    const struct STFTPlan* plan = pass->plan;
+    const int N = plan->N;
+    const double* w = plan->window;
+    struct FFTArena* arena = fft_thread_arena();
+    const struct FFTArenaMark mark = fft_arena_mark(arena);
+    struct Complex* work = fft_arena_cplx_arr(arena, stft_work_size(plan));
+    if (work == NULL) {
+        fft_arena_release(arena, mark);
+        return;
+    }
+
+    for (int t = begin; t < end; t++) {
+        if (pass->frames_real != NULL) {
+            double* frame = pass->frames_real + (size_t) t * N;
+            rfft_plan_execute_c2r(plan->rbackward, cplx_2d_row(pass->X_in, t), frame, work);
+            for (int n = 0; n < N; n++) {
+                frame[n] *= w[n];
+            }
+        } else {
+            struct Complex* frame = pass->frames + (size_t) t * N;
+            fft_plan_execute_work(plan->backward, cplx_2d_row(pass->X_in, t), frame, work);
+            for (int n = 0; n < N; n++) {
+                frame[n].real *= w[n];
+                frame[n].imag *= w[n];
+            }
+        }
+    }
+    fft_arena_release(arena, mark);
+}
+
+/* Each output sample gathers the frames covering it, so threads never write the same sample. */
+static void istft_overlap_add_range(void* ctx, const int begin, const int end, const int thread) {
+    (void) thread;
+    const struct STFTPass* pass = ctx;
+    const struct STFTPlan* plan = pass->plan;
+    const int N = plan->N;
+    const int hop = plan->hop;
+    const int last_frame = pass->X_in->height - 1;
+    const double* w = plan->window;
+
+    for (int i = begin; i < end; i++) {
+        /* Frame t covers samples t * hop - N / 2 .. t * hop - N / 2 + N - 1. */
+        const int first = i + N / 2 - N + 1;
+        const int t_begin = first <= 0 ? 0 : (first + hop - 1) / hop;
+        const int t_end = (i + N / 2) / hop < last_frame ? (i + N / 2) / hop : last_frame;
+        double norm = 0;
+        double re = 0;
+        double im = 0;
+        for (int t = t_begin; t <= t_end; t++) {
+            const int n = i - (t * hop - N / 2);
+            norm += w[n] * w[n];
+            if (pass->frames_real != NULL) {
+                re += pass->frames_real[(size_t) t * N + n];
+            } else {
+                re += pass->frames[(size_t) t * N + n].real;
+                im += pass->frames[(size_t) t * N + n].imag;
+            }
+        }
+        const double scale = norm > 1e-12 ? 1.0 / norm : 0;
+        if (pass->y_real != NULL) {
+            pass->y_real[i] = re * scale;
+        } else {
+            pass->y[i] = (struct Complex){re * scale, im * scale};
+        }
+    }
+}
+
+static int istft_check(const struct Complex2D* X, const int width, const int len) {
+    if (X->width != width || X->height < 1 || len < 1) {
+        fprintf(stderr, "istft: invalid %dx%d frames (expected %d bins) or len=%d\n", X->height, X->width, width, len);
+        return -1;
+    }
+    return 0;
+}
+
+double* istft_real(const struct STFTPlan* plan, const struct Complex2D* X, const int len) {
+    if (istft_check(X, plan->N / 2 + 1, len) != 0) {
+        return NULL;
+    }
+    double* frames = malloc((size_t) X->height * plan->N * sizeof(double));
+    double* y = malloc(len * sizeof(double));
+    if (frames == NULL || y == NULL) {
+        fprintf(stderr, "istft_real failed\n");
+        free(frames);
+        free(y);
+        return NULL;
+    }
+    struct STFTPass pass = {plan, len, NULL, NULL, NULL, X, frames, NULL, y, NULL};
+    parallel_for(X->height, 1, istft_frames_range, &pass);
+    parallel_for(len, STFT_OLA_BLOCK, istft_overlap_add_range, &pass);
+    free(frames);
+    return y;
+}
+
+struct Complex* istft(const struct STFTPlan* plan, const struct Complex2D* X, const int len) {
+    if (istft_check(X, plan->N, len) != 0) {
+        return NULL;
+    }
+    struct Complex* frames = fft_malloc((size_t) X->height * plan->N * sizeof(struct Complex));
+    struct Complex* y = malloc_cplx_arr(len);
+    if (frames == NULL || y == NULL) {
+        fprintf(stderr, "istft failed\n");
+        fft_free(frames);
+        fft_free(y);
+        return NULL;
+    }
+    struct STFTPass pass = {plan, len, NULL, NULL, NULL, X, NULL, frames, NULL, y};
+    parallel_for(X->height, 1, istft_frames_range, &pass);
+    parallel_for(len, STFT_OLA_BLOCK, istft_overlap_add_range, &pass);
+    fft_free(frames);
+    return y;
+}
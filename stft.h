@@ -0,0 +1,62 @@
+#ifndef STFT_H
+#define STFT_H
+#include "complex.h"
+#include "plan.h"
+#include "rfft.h"
+#include "util.h"
+
+/* WINDOWS */
+enum WindowType {
+    WINDOW_RECTANGULAR,
+    WINDOW_HANN,
+    WINDOW_HAMMING,
+    WINDOW_BLACKMAN,
+    WINDOW_KAISER       /* shape set by beta */
+};
+
+/* Periodic window of length N (the symmetric N + 1 window without its last point), as spectral analysis uses. */
+double* stft_window(enum WindowType type, int N, double beta);
+
+/*
+ * SHORT-TIME FOURIER TRANSFORM
+ * Frames of N samples every hop samples, each multiplied by the window and
+ * transformed. Frame t is centered on sample t * hop, with zeros beyond
+ * either end of the signal, and there are just enough frames to cover every
+ * sample (stft_frame_count). Spectra are the rows of a Complex2D: N / 2 + 1 bins for real
+ * input, N for complex. All frames share the plan's transforms and are
+ * spread over the thread pool.
+ */
+struct STFTPlan {
+    int N;                          /* frame length */
+    int hop;
+    double* window;                 /* N samples, used for analysis and synthesis */
+    struct RealFFTPlan* rforward;   /* real input, owned by this plan */
+    struct RealFFTPlan* rbackward;
+    const struct FFTPlan* forward;  /* complex input, owned by the plan cache */
+    const struct FFTPlan* backward;
+};
+
+/* beta is only used by WINDOW_KAISER. hop must be in [1, N]. */
+struct STFTPlan* stft_plan_create(int N, int hop, enum WindowType window, double beta);
+
+void stft_plan_destroy(struct STFTPlan* plan);
+
+int stft_frame_count(const struct STFTPlan* plan, int len);
+
+/* Returns stft_frame_count(len) rows of N / 2 + 1 bins. */
+struct Complex2D* stft_real(const struct STFTPlan* plan, const double* x, int len);
+
+/* Returns stft_frame_count(len) rows of N bins. */
+struct Complex2D* stft(const struct STFTPlan* plan, const struct Complex* x, int len);
+
+/*
+ * INVERSE STFT
+ * Windowed overlap-add of the inverse-transformed frames, divided by the
+ * summed squared window at each sample, which undoes stft exactly whenever
+ * that sum is nonzero (hop <= N / 2 for Hann and Blackman). Returns len samples.
+ */
+double* istft_real(const struct STFTPlan* plan, const struct Complex2D* X, int len);
+
+struct Complex* istft(const struct STFTPlan* plan, const struct Complex2D* X, int len);
+
+#endif //STFT_H
@@ -3,10 +3,43 @@
 #define STB_IMAGE_WRITE_IMPLEMENTATION
 #include "stb/stb_image_write.h"
 
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
 #include "complex.h"
+#include "conv.h"
 #include "util.h"
 #include "test.h"
 #include "fft.h"
+#include "fftf.h"
+#include "plan.h"
+#include "planner.h"
+#include "rfft.h"
+#include "stft.h"
+#include "utilf.h"
+
+/* Single-precision fftf / ifftf on a double array, widened back for printing. */
+static struct Complex* test_fftf(const struct Complex* x, const int N, const int inverse) {
+    struct ComplexF* xf = cplx_to_cplxf_arr(x, N);
+    struct ComplexF* Xf = inverse ? ifftf(xf, N) : fftf(xf, N);
+    struct Complex* X = Xf != NULL ? cplxf_to_cplx_arr(Xf, N) : NULL;
+    fft_free(xf);
+    fft_free(Xf);
+    return X;
+}
+
+/* One transform with an explicitly chosen plan algorithm. */
+static struct Complex* test_plan(const struct Complex* x, const int N, const int inverse,
+                                 const enum PlanAlgorithm algorithm) {
+    struct FFTPlan* plan = fft_plan_create_algorithm(N, inverse, algorithm);
+    if (plan == NULL) {
+        return NULL;
+    }
+    struct Complex* X = fft_plan_execute(plan, x);
+    fft_plan_destroy(plan);
+    return X;
+}
 
 void test_fft(const enum FFTType fft_type, const double* test_arr, const int N) {
     struct Complex* test_cplx_arr = to_cplx_arr(test_arr, N);
@@ -33,10 +66,26 @@ void test_fft(const enum FFTType fft_type, const double* test_arr, const int N)
             printf("ITER_RADIX_2 ");
             fft_cplx_arr = iter_fft(test_cplx_arr, N);
             break;
+        case RADIX_4:
+            printf("RADIX_4 ");
+            fft_cplx_arr = radix_4_fft(test_cplx_arr, N);
+            break;
         case BLUESTEIN:
             printf("BLUESTEIN ");
             fft_cplx_arr = bluestein_fft(test_cplx_arr, N);
             break;
+        case AUTO:
+            printf("AUTO (%s) ", plan_algorithm_name(fft_plan_get(N, 0)->algorithm));
+            fft_cplx_arr = fft(test_cplx_arr, N);
+            break;
+        case FLOAT:
+            printf("FLOAT ");
+            fft_cplx_arr = test_fftf(test_cplx_arr, N, 0);
+            break;
+        case STOCKHAM:
+            printf("STOCKHAM ");
+            fft_cplx_arr = test_plan(test_cplx_arr, N, 0, PLAN_STOCKHAM);
+            break;
         default:
             printf("WRONG FFT SPECIFIED \n");
             break;
@@ -60,10 +109,26 @@ void test_fft(const enum FFTType fft_type, const double* test_arr, const int N)
             printf("ITER_RADIX_2 ");
             ifft_cplx_arr = iter_ifft(fft_cplx_arr, N);
             break;
+        case RADIX_4:
+            printf("RADIX_4 ");
+            ifft_cplx_arr = radix_4_ifft(fft_cplx_arr, N);
+            break;
         case BLUESTEIN:
             printf("BLUESTEIN ");
             ifft_cplx_arr = bluestein_ifft(fft_cplx_arr, N);
             break;
+        case AUTO:
+            printf("AUTO (%s) ", plan_algorithm_name(fft_plan_get(N, 1)->algorithm));
+            ifft_cplx_arr = ifft(fft_cplx_arr, N);
+            break;
+        case FLOAT:
+            printf("FLOAT ");
+            ifft_cplx_arr = test_fftf(fft_cplx_arr, N, 1);
+            break;
+        case STOCKHAM:
+            printf("STOCKHAM ");
+            ifft_cplx_arr = test_plan(fft_cplx_arr, N, 1, PLAN_STOCKHAM);
+            break;
         default:
             printf("WRONG FFT SPECIFIED \n");
             break;
@@ -78,38 +143,38 @@ void test_fft(const enum FFTType fft_type, const double* test_arr, const int N)
     print_double_arr(final_arr, N);
     printf("\n");
 
-    free(test_cplx_arr);
-    free(fft_cplx_arr);
-    free(ifft_cplx_arr);
+    fft_free(test_cplx_arr);
+    fft_free(fft_cplx_arr);
+    fft_free(ifft_cplx_arr);
     free(final_arr);
 }
 
 void test_fft_2d(const double* test_arr, const int height, const int width) {
 
-    struct Complex** test_cplx_arr_2d = to_2d_cplx_arr(test_arr, height, width);
+    struct Complex2D* test_cplx_arr_2d = to_2d_cplx_arr(test_arr, height, width);
     printf("2D ARRAY\n");
-    print_2d_cplx_arr(test_cplx_arr_2d, height, width);
+    print_2d_cplx_arr(test_cplx_arr_2d);
     printf("\n");
 
-    struct Complex** fft_cplx_arr_2d = fft_2d(test_cplx_arr_2d, height, width);
+    struct Complex2D* fft_cplx_arr_2d = fft_2d(test_cplx_arr_2d);
     printf("2D FFT\n");
-    print_2d_cplx_arr(fft_cplx_arr_2d, height, width);
+    print_2d_cplx_arr(fft_cplx_arr_2d);
     printf("\n");
 
-    struct Complex** ifft_cplx_arr_2d = ifft_2d(fft_cplx_arr_2d, height, width);
+    struct Complex2D* ifft_cplx_arr_2d = ifft_2d(fft_cplx_arr_2d);
     printf("2D IFFT\n");
-    print_2d_cplx_arr(ifft_cplx_arr_2d, height, width);
+    print_2d_cplx_arr(ifft_cplx_arr_2d);
     printf("\n");
 
-    struct Complex** fft_cplx_arr_2d_shift = fft_shift_2d(fft_cplx_arr_2d, height, width);
+    struct Complex2D* fft_cplx_arr_2d_shift = fft_shift_2d(fft_cplx_arr_2d);
     printf("FFT SHIFT\n");
-    print_2d_cplx_arr(fft_cplx_arr_2d_shift, height, width);
+    print_2d_cplx_arr(fft_cplx_arr_2d_shift);
     printf("\n");
 
-   free_2d(test_cplx_arr_2d, height);
-   free_2d(fft_cplx_arr_2d, height);
-   free_2d(ifft_cplx_arr_2d, height);
-   free_2d(fft_cplx_arr_2d_shift, height);
+   free_2d(test_cplx_arr_2d);
+   free_2d(fft_cplx_arr_2d);
+   free_2d(ifft_cplx_arr_2d);
+   free_2d(fft_cplx_arr_2d_shift);
 }
 
 void test_fft_image(const char* filename, const char* output_filename) {
@@ -120,17 +185,15 @@ void test_fft_image(const char* filename, const char* output_filename) {
 
     printf("\nConverting image to grayscale...\n");
     double* gray_img = to_grayscale(img, height, width, ch);
-    printf("Converting image array to complex type...\n");
-    struct Complex** cplx_img = to_2d_cplx_arr(gray_img, height, width);
 
     printf("Calculating FFT...\n");
-    struct Complex** fft_img = fft_2d(cplx_img, height, width);
-    printf("Shifting FFT...\n");
-    struct Complex** fft_img_shifted = fft_shift_2d(fft_img, height, width);
+    struct Complex2D* fft_img = rfft_2d(gray_img, height, width);
     printf("Calculating amplitude...\n");
-    double* flat_amp_arr = to_amplitude_arr(fft_img_shifted, height, width);
+    double* flat_amp_arr = to_amplitude_arr_half(fft_img, width);
+    printf("Shifting FFT...\n");
+    double* flat_amp_arr_shifted = fft_shift_2d_real(flat_amp_arr, height, width);
     printf("Preparing the FFT array for saving...\n");
-    unsigned char* write_ready_arr = to_char_arr(flat_amp_arr, height, width);
+    unsigned char* write_ready_arr = to_char_arr(flat_amp_arr_shifted, height, width);
 
     printf("\nSaving image...\n");
     stbi_write_jpg(output_filename, width, height, 1, write_ready_arr, 100);
@@ -138,9 +201,435 @@ void test_fft_image(const char* filename, const char* output_filename) {
 
     stbi_image_free(img);
     free(gray_img);
-    free(cplx_img);
-    free(fft_img);
-    free(fft_img_shifted);
+    free_2d(fft_img);
     free(flat_amp_arr);
+    free(flat_amp_arr_shifted);
     free(write_ready_arr);
-}
\ No newline at end of file
+}
+/* Largest |y - direct sum| over the nx + nh - 1 outputs, relative to the largest output. */
+static double conv_error(const struct Complex* x, const int nx, const struct Complex* h, const int nh,
+                         const int correlate, const struct Complex* y) {
+    double error = 0;
+    double scale = 0;
+    for (int k = 0; k < nx + nh - 1; k++) {
+        struct Complex sum = {0, 0};
+        for (int m = 0; m < nh; m++) {
+            if (k - m < 0 || k - m >= nx) {
+                continue;
+            }
+            const struct Complex g = correlate ? conj_q(h[nh - 1 - m]) : h[m];
+            sum = add_q(sum, mul_q(x[k - m], g));
+        }
+        error = fmax(error, amplitude_q(sub_q(y[k], sum)));
+        scale = fmax(scale, amplitude_q(sum));
+    }
+    return scale > 0 ? error / scale : error;
+}
+
+/*
+ * Wisdom chooses different algorithms for the forward and inverse transforms
+ * of the convolution lengths (512 and 1024), as measure mode can do. The
+ * wisdom found beforehand is saved to restore afterwards.
+ */
+static int test_conv_force_mismatch(FILE* saved) {
+    FILE* planted = tmpfile();
+    if (planted == NULL || fft_wisdom_export_file(saved) != 0 || fft_wisdom_export_file(planted) != 0) {
+        if (planted != NULL) {
+            fclose(planted);
+        }
+        return -1;
+    }
+    fprintf(planted, "512 0 RADIX_4 -\n512 1 STOCKHAM -\n1024 0 STOCKHAM -\n1024 1 RADIX_2 -\n");
+    rewind(planted);
+    fft_plan_cache_clear();
+    const int result = fft_wisdom_import_file(planted);
+    fclose(planted);
+    return result;
+}
+
+int test_conv(void) {
+    FILE* saved = tmpfile();
+    if (saved == NULL || test_conv_force_mismatch(saved) != 0) {
+        printf("Could not set up mismatched plans\n");
+        if (saved != NULL) {
+            fclose(saved);
+        }
+        return 1;
+    }
+    printf("Forward / inverse plans at 512: %s / %s, at 1024: %s / %s\n",
+           plan_algorithm_name(fft_plan_get(512, 0)->algorithm), plan_algorithm_name(fft_plan_get(512, 1)->algorithm),
+           plan_algorithm_name(fft_plan_get(1024, 0)->algorithm), plan_algorithm_name(fft_plan_get(1024, 1)->algorithm));
+
+    const int sizes[][2] = {{300, 200}, {700, 300}};
+    int failed = 0;
+    for (int s = 0; s < 2; s++) {
+        const int nx = sizes[s][0];
+        const int nh = sizes[s][1];
+        struct Complex* x = malloc_cplx_arr(nx);
+        struct Complex* h = malloc_cplx_arr(nh);
+        double* x_real = malloc(nx * sizeof(double));
+        double* h_real = malloc(nh * sizeof(double));
+        struct Complex* y_real_cplx = malloc_cplx_arr(nx + nh - 1);
+        for (int i = 0; i < nx; i++) {
+            x[i] = (struct Complex){sin(0.1 * i), cos(0.37 * i)};
+            x_real[i] = x[i].real;
+        }
+        for (int i = 0; i < nh; i++) {
+            h[i] = (struct Complex){cos(0.05 * i), sin(0.2 * i)};
+            h_real[i] = h[i].real;
+        }
+
+        struct Complex* y = convolve(x, nx, h, nh);
+        struct Complex* c = cross_correlate(x, nx, h, nh);
+        double* y_real = convolve_real(x_real, nx, h_real, nh);
+        const double error_conv = conv_error(x, nx, h, nh, 0, y);
+        const double error_corr = conv_error(x, nx, h, nh, 1, c);
+        struct Complex* x_re = to_cplx_arr(x_real, nx);
+        struct Complex* h_re = to_cplx_arr(h_real, nh);
+        for (int i = 0; i < nx + nh - 1; i++) {
+            y_real_cplx[i] = (struct Complex){y_real[i], 0};
+        }
+        const double error_real = conv_error(x_re, nx, h_re, nh, 0, y_real_cplx);
+
+        printf("nx=%d nh=%d: convolve %.2e, cross_correlate %.2e, convolve_real %.2e\n",
+               nx, nh, error_conv, error_corr, error_real);
+        failed |= !(error_conv < 1e-9 && error_corr < 1e-9 && error_real < 1e-9);
+
+        fft_free(x);
+        fft_free(h);
+        free(x_real);
+        free(h_real);
+        fft_free(y_real_cplx);
+        fft_free(y);
+        fft_free(c);
+        free(y_real);
+        fft_free(x_re);
+        fft_free(h_re);
+    }
+
+    fft_wisdom_forget();
+    fft_plan_cache_clear();
+    rewind(saved);
+    fft_wisdom_import_file(saved);
+    fclose(saved);
+    printf(failed ? "CONV FAILED\n" : "CONV PASSED\n");
+    return failed;
+}
+
+/*
+ * Streams n samples through the filter in uneven chunks (single samples, odd
+ * sizes, more than a block) and returns the largest difference from the
+ * reference delayed by the filter's latency B; the first B outputs must be 0.
+ */
+static double fir_stream_error(struct FIRFilter* filter, const double* x, const int n, const double* reference,
+                               const int B) {
+    const int chunks[] = {1, 7, 300, 64, 2, 129, 1000, 33};
+    double* y = malloc(n * sizeof(double));
+    if (y == NULL) {
+        return INFINITY;
+    }
+    for (int i = 0, c = 0; i < n; c = (c + 1) % 8) {
+        const int count = chunks[c] < n - i ? chunks[c] : n - i;
+        fir_filter_process(filter, x + i, count, y + i);
+        i += count;
+    }
+
+    double error = 0;
+    for (int k = 0; k < n; k++) {
+        error = fmax(error, fabs(y[k] - (k < B ? 0 : reference[k - B])));
+    }
+    free(y);
+    return error;
+}
+
+int test_fir(void) {
+    const int n = 5000;
+    const int kernel_sizes[] = {7, 200};
+    const int blocks[] = {0, 16, 100};
+    const enum FIRMethod methods[] = {FIR_OVERLAP_SAVE, FIR_OVERLAP_ADD};
+    double* x = malloc(n * sizeof(double));
+    const int nh_max = 3000;
+    double* h = malloc(nh_max * sizeof(double));
+    if (x == NULL || h == NULL) {
+        free(x);
+        free(h);
+        return 1;
+    }
+    for (int i = 0; i < n; i++) {
+        x[i] = sin(0.1 * i) + 0.5 * cos(0.37 * i);
+    }
+    for (int i = 0; i < nh_max; i++) {
+        h[i] = cos(0.05 * i) * exp(-0.01 * i);
+    }
+
+    int failed = 0;
+    for (int k = 0; k < 2; k++) {
+        const int nh = kernel_sizes[k];
+        double* reference = convolve_real(x, n, h, nh);
+        for (int b = 0; b < 3; b++) {
+            for (int m = 0; m < 2; m++) {
+                struct FIRFilter* filter = fir_filter_create(h, nh, blocks[b], methods[m]);
+                if (filter == NULL || reference == NULL) {
+                    failed = 1;
+                    fir_filter_destroy(filter);
+                    continue;
+                }
+                /* twice, to check that reset clears the history */
+                const double error = fir_stream_error(filter, x, n, reference, filter->B);
+                fir_filter_reset(filter);
+                const double error_reset = fir_stream_error(filter, x, n, reference, filter->B);
+                printf("nh=%d B=%d %s: %.2e, after reset %.2e\n", nh, filter->B,
+                       methods[m] == FIR_OVERLAP_SAVE ? "overlap-save" : "overlap-add", error, error_reset);
+                failed |= !(error < 1e-9 && error_reset < 1e-9);
+                fir_filter_destroy(filter);
+            }
+        }
+        free(reference);
+    }
+
+    /* uniform partitions, then stages growing from block to max_block */
+    const int partitioned_kernel_sizes[] = {200, nh_max};
+    const int partitions[][2] = {{16, 0}, {24, 24}, {16, 1024}, {24, 200}};
+    for (int k = 0; k < 2; k++) {
+        const int nh = partitioned_kernel_sizes[k];
+        double* reference = convolve_real(x, n, h, nh);
+        for (int p = 0; p < 4; p++) {
+            const int block = partitions[p][0];
+            struct FIRFilter* filter = fir_filter_create_partitioned(h, nh, block, partitions[p][1]);
+            if (filter == NULL || reference == NULL) {
+                failed = 1;
+                fir_filter_destroy(filter);
+                continue;
+            }
+            int stages = 0;
+            for (const struct FIRFilter* stage = filter; stage != NULL; stage = stage->next) {
+                stages++;
+            }
+            const double error = fir_stream_error(filter, x, n, reference, block);
+            fir_filter_reset(filter);
+            const double error_reset = fir_stream_error(filter, x, n, reference, block);
+            printf("nh=%d partitioned block=%d max_block=%d (%d stages): %.2e, after reset %.2e\n",
+                   nh, block, partitions[p][1], stages, error, error_reset);
+            failed |= !(error < 1e-9 && error_reset < 1e-9);
+            fir_filter_destroy(filter);
+        }
+        free(reference);
+    }
+
+    free(x);
+    free(h);
+    printf(failed ? "FIR FAILED\n" : "FIR PASSED\n");
+    return failed;
+}
+
+/* Largest difference of frame t of X from the directly computed windowed DFT of x (real input if x_imag is NULL). */
+static double stft_frame_error(const struct STFTPlan* plan, const double* x_real, const double* x_imag, const int len,
+                               const struct Complex2D* X, const int t) {
+    const int N = plan->N;
+    const int start = t * plan->hop - N / 2;
+    double error = 0;
+    for (int k = 0; k < X->width; k++) {
+        struct Complex sum = {0, 0};
+        for (int n = 0; n < N; n++) {
+            if (start + n < 0 || start + n >= len) {
+                continue;
+            }
+            const struct Complex v = {x_real[start + n] * plan->window[n],
+                                      x_imag != NULL ? x_imag[start + n] * plan->window[n] : 0};
+            sum = add_q(sum, mul_q(v, (struct Complex){cos(2 * M_PI * k * n / N), -sin(2 * M_PI * k * n / N)}));
+        }
+        error = fmax(error, amplitude_q(sub_q(cplx_2d_row(X, t)[k], sum)));
+    }
+    return error;
+}
+
+int test_stft(void) {
+    /* hop <= N / 2 for Hann and Blackman, any hop up to N for the others; odd and non-power-of-two N */
+    const struct {
+        int N;
+        int hop;
+        enum WindowType window;
+    } configs[] = {
+        {64, 16, WINDOW_HANN}, {100, 50, WINDOW_HANN}, {15, 5, WINDOW_HAMMING},
+        {256, 64, WINDOW_BLACKMAN}, {48, 48, WINDOW_RECTANGULAR}, {64, 64, WINDOW_KAISER}
+    };
+    const int len = 1000;
+    double* x_real = malloc(len * sizeof(double));
+    double* x_imag = malloc(len * sizeof(double));
+    struct Complex* x = malloc_cplx_arr(len);
+    if (x_real == NULL || x_imag == NULL || x == NULL) {
+        free(x_real);
+        free(x_imag);
+        fft_free(x);
+        return 1;
+    }
+    for (int i = 0; i < len; i++) {
+        x_real[i] = sin(0.1 * i) + 0.3 * sin(0.013 * i * i);
+        x_imag[i] = cos(0.37 * i);
+        x[i] = (struct Complex){x_real[i], x_imag[i]};
+    }
+
+    int failed = 0;
+    for (size_t c = 0; c < sizeof(configs) / sizeof(configs[0]); c++) {
+        struct STFTPlan* plan = stft_plan_create(configs[c].N, configs[c].hop, configs[c].window, 8.6);
+        struct Complex2D* X_real = plan != NULL ? stft_real(plan, x_real, len) : NULL;
+        struct Complex2D* X = plan != NULL ? stft(plan, x, len) : NULL;
+        double* y_real = X_real != NULL ? istft_real(plan, X_real, len) : NULL;
+        struct Complex* y = X != NULL ? istft(plan, X, len) : NULL;
+        if (y_real == NULL || y == NULL) {
+            failed = 1;
+        } else {
+            /* the first frame, straddling the start of the signal, and one inside it */
+            double error_frame = 0;
+            for (int t = 0; t <= 3; t += 3) {
+                error_frame = fmax(error_frame, stft_frame_error(plan, x_real, NULL, len, X_real, t));
+                error_frame = fmax(error_frame, stft_frame_error(plan, x_real, x_imag, len, X, t));
+            }
+            double error_real = 0;
+            double error_cplx = 0;
+            for (int i = 0; i < len; i++) {
+                error_real = fmax(error_real, fabs(y_real[i] - x_real[i]));
+                error_cplx = fmax(error_cplx, amplitude_q(sub_q(y[i], x[i])));
+            }
+            printf("N=%d hop=%d window=%d, %d frames: frames %.2e, round trip real %.2e, complex %.2e\n",
+                   configs[c].N, configs[c].hop, configs[c].window, X->height, error_frame, error_real, error_cplx);
+            failed |= !(error_frame < 1e-9 && error_real < 1e-9 && error_cplx < 1e-9);
+        }
+        free_2d(X_real);
+        free_2d(X);
+        free(y_real);
+        fft_free(y);
+        stft_plan_destroy(plan);
+    }
+
+    free(x_real);
+    free(x_imag);
+    fft_free(x);
+    printf(failed ? "STFT FAILED\n" : "STFT PASSED\n");
+    return failed;
+}
+
+/* Largest |X[k] - reference[k]|, relative to the largest reference value. */
+static double max_error(const struct Complex* X, const struct Complex* reference, const int N) {
+    double error = 0;
+    double scale = 0;
+    for (int k = 0; k < N; k++) {
+        error = fmax(error, amplitude_q(sub_q(X[k], reference[k])));
+        scale = fmax(scale, amplitude_q(reference[k]));
+    }
+    return scale > 0 ? error / scale : error;
+}
+
+int test_batch(void) {
+    /* contiguous, interleaved channels (stride = howmany, dist = 1), padded rows, in place and out of place */
+    const struct {
+        int N, howmany, istride, idist, ostride, odist, in_place, inverse;
+    } layouts[] = {
+        {64, 100, 1, 64, 1, 64, 0, 0},
+        {60, 37, 1, 60, 1, 60, 1, 1},
+        {128, 8, 8, 1, 1, 128, 0, 0},
+        {17, 40, 40, 1, 40, 1, 1, 0},
+        {256, 33, 33, 1, 33, 1, 0, 1},
+        {12, 5, 1, 20, 2, 30, 0, 0}
+    };
+
+    int failed = 0;
+    for (size_t l = 0; l < sizeof(layouts) / sizeof(layouts[0]); l++) {
+        const int N = layouts[l].N;
+        const int howmany = layouts[l].howmany;
+        const int istride = layouts[l].istride;
+        const int idist = layouts[l].idist;
+        const int ostride = layouts[l].ostride;
+        const int odist = layouts[l].odist;
+        const int in_len = (howmany - 1) * idist + (N - 1) * istride + 1;
+        const int out_len = (howmany - 1) * odist + (N - 1) * ostride + 1;
+        struct Complex* x = calloc_cplx_arr(in_len > out_len ? in_len : out_len);
+        struct Complex* X = layouts[l].in_place ? x : calloc_cplx_arr(out_len);
+        struct Complex* signal = malloc_cplx_arr(N);
+        struct Complex* out = malloc_cplx_arr(N);
+        struct Complex** references = malloc(howmany * sizeof(struct Complex*));
+        if (x == NULL || X == NULL || signal == NULL || out == NULL || references == NULL) {
+            failed = 1;
+        } else {
+            for (int i = 0; i < in_len; i++) {
+                x[i] = (struct Complex){sin(0.1 * i), cos(0.37 * i)};
+            }
+            for (int b = 0; b < howmany; b++) {
+                for (int k = 0; k < N; k++) {
+                    signal[k] = x[b * idist + k * istride];
+                }
+                references[b] = dft_base(signal, N, layouts[l].inverse);
+            }
+
+            const int status = layouts[l].inverse ? ifft_many(x, N, howmany, istride, idist, X, ostride, odist)
+                                                  : fft_many(x, N, howmany, istride, idist, X, ostride, odist);
+            double error = 0;
+            for (int b = 0; b < howmany; b++) {
+                for (int k = 0; k < N; k++) {
+                    out[k] = X[b * odist + k * ostride];
+                }
+                error = references[b] != NULL ? fmax(error, max_error(out, references[b], N)) : INFINITY;
+                fft_free(references[b]);
+            }
+            printf("N=%d howmany=%d in %d/%d out %d/%d%s%s: %.2e\n", N, howmany, istride, idist, ostride, odist,
+                   layouts[l].in_place ? " in place" : "", layouts[l].inverse ? " inverse" : "", error);
+            failed |= !(status == 0 && error < 1e-9);
+        }
+        if (X != x) {
+            fft_free(X);
+        }
+        fft_free(x);
+        fft_free(signal);
+        fft_free(out);
+        free(references);
+    }
+
+    printf(failed ? "BATCH FAILED\n" : "BATCH PASSED\n");
+    return failed;
+}
+
+int test_four_step(void) {
+    /* square, non-square and non-power-of-two splits; the DFT is the reference while it is affordable */
+    const int sizes[] = {256, 4800, 26880, 1 << 16, 1 << 20};
+    const int dft_max = 4800;
+
+    int failed = 0;
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        const int N = sizes[s];
+        struct Complex* x = malloc_cplx_arr(N);
+        if (x == NULL) {
+            failed = 1;
+            continue;
+        }
+        for (int i = 0; i < N; i++) {
+            x[i] = (struct Complex){sin(0.1 * i) + cos(0.0001 * i * (double) i), cos(0.37 * i)};
+        }
+
+        struct Complex* X = fft_four_step(x, N);
+        struct Complex* y = X != NULL ? ifft_four_step(X, N) : NULL;
+        const struct FFTPlan* plan = NULL;
+        struct Complex* reference = NULL;
+        if (N <= dft_max) {
+            reference = dft(x, N);
+        } else if ((plan = fft_plan_get(N, 0)) != NULL) {
+            reference = fft_plan_execute(plan, x);
+        }
+        if (y == NULL || reference == NULL) {
+            failed = 1;
+        } else {
+            const double error = max_error(X, reference, N);
+            const double error_round_trip = max_error(y, x, N);
+            printf("N=%d (%d x %d): against %s %.2e, round trip %.2e\n", N, fft_four_step_split(N),
+                   N / fft_four_step_split(N), plan != NULL ? plan_algorithm_name(plan->algorithm) : "DFT", error,
+                   error_round_trip);
+            failed |= !(error < 1e-9 && error_round_trip < 1e-9);
+        }
+        fft_free(x);
+        fft_free(X);
+        fft_free(y);
+        fft_free(reference);
+    }
+
+    printf(failed ? "FOUR_STEP FAILED\n" : "FOUR_STEP PASSED\n");
+    return failed;
+}
@@ -1,9 +1,9 @@
 #ifndef TEST_H
 #define TEST_H
 
-enum FFTType {RADIX_2, ITER_RADIX_2, DFT, BLUESTEIN, FFT_NONE};
+enum FFTType {RADIX_2, ITER_RADIX_2, RADIX_4, DFT, BLUESTEIN, AUTO, FLOAT, STOCKHAM, FFT_NONE};
 
-enum TestType {FFT1, FFT2, FFT_IMAGE};
+enum TestType {FFT1, FFT2, FFT_IMAGE, CONV, FIR, STFT, BATCH, FOUR_STEP};
 
 void test_fft(enum FFTType fft_type, const double* test_arr, int N);
 
@@ -11,4 +11,19 @@ void test_fft_2d(const double* test_arr, int height, int width);
 
 void test_fft_image(const char* filename, const char* output_filename);
 
+/* Checks convolve / cross_correlate / convolve_real against direct sums. Returns 0 on success. */
+int test_conv(void);
+
+/* Streams a signal through single and partitioned FIR filters, against convolve_real. Returns 0 on success. */
+int test_fir(void);
+
+/* Checks stft / stft_real frames against direct windowed DFTs and the istft round trip. Returns 0 on success. */
+int test_stft(void);
+
+/* Checks fft_many / ifft_many on contiguous, interleaved and padded layouts against the DFT. Returns 0 on success. */
+int test_batch(void);
+
+/* Checks fft_four_step against the DFT or a single plan, and its inverse round trip. Returns 0 on success. */
+int test_four_step(void);
+
 #endif //TEST_H
\ No newline at end of file
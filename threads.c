@@ -0,0 +1,152 @@
+#include "threads.h"
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+struct ParallelJob {
+    parallel_fn fn;
+    void* ctx;
+    int count;
+    int grain;
+    int n_chunks;
+    int next_chunk;
+    int pending;
+};
+
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t work_ready = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t work_done = PTHREAD_COND_INITIALIZER;
+/* Held by the thread currently dispatching a job; others fall back to serial execution. */
+static pthread_mutex_t dispatch_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static pthread_t* workers = NULL;
+/* Written under dispatch_lock; atomic so fft_get_threads can read it inside a job, where that lock is taken. */
+static atomic_int n_workers = 0;
+static int shutting_down = 0;
+static unsigned long generation = 0;
+static struct ParallelJob job;
+
+static _Thread_local int inside_job = 0;
+
+static void chunk_range(const struct ParallelJob* j, const int chunk, int* begin, int* end) {
+    const int units = (j->count + j->grain - 1) / j->grain;
+    const int first = (int) ((long long) units * chunk / j->n_chunks);
+    const int last = (int) ((long long) units * (chunk + 1) / j->n_chunks);
+    *begin = first * j->grain;
+    *end = last * j->grain < j->count ? last * j->grain : j->count;
+}
+
+/* Takes chunks of the current job until none are left. Called with pool_lock held. */
+static void run_chunks(void) {
+    while (job.next_chunk < job.n_chunks) {
+        const int chunk = job.next_chunk++;
+        int begin, end;
+        chunk_range(&job, chunk, &begin, &end);
+        pthread_mutex_unlock(&pool_lock);
+
+        inside_job = 1;
+        if (begin < end) {
+            job.fn(job.ctx, begin, end, chunk);
+        }
+        inside_job = 0;
+
+        pthread_mutex_lock(&pool_lock);
+        if (--job.pending == 0) {
+            pthread_cond_broadcast(&work_done);
+        }
+    }
+}
+
+static void* worker_main(void* arg) {
+    (void) arg;
+    unsigned long seen = 0;
+    pthread_mutex_lock(&pool_lock);
+    while (1) {
+        while (!shutting_down && generation == seen) {
+            pthread_cond_wait(&work_ready, &pool_lock);
+        }
+        if (shutting_down) {
+            break;
+        }
+        seen = generation;
+        run_chunks();
+    }
+    pthread_mutex_unlock(&pool_lock);
+    return NULL;
+}
+
+static void stop_workers(void) {
+    pthread_mutex_lock(&pool_lock);
+    shutting_down = 1;
+    pthread_cond_broadcast(&work_ready);
+    pthread_mutex_unlock(&pool_lock);
+    for (int i = 0; i < n_workers; i++) {
+        pthread_join(workers[i], NULL);
+    }
+    free(workers);
+    workers = NULL;
+    n_workers = 0;
+    shutting_down = 0;
+}
+
+void fft_set_threads(const int n_threads) {
+    pthread_mutex_lock(&dispatch_lock);
+    stop_workers();
+
+    const int wanted = n_threads > 1 ? n_threads - 1 : 0;
+    if (wanted > 0) {
+        workers = malloc(wanted * sizeof(pthread_t));
+        if (workers == NULL) {
+            fprintf(stderr, "fft_set_threads failed\n");
+            pthread_mutex_unlock(&dispatch_lock);
+            return;
+        }
+        for (int i = 0; i < wanted; i++) {
+            if (pthread_create(&workers[i], NULL, worker_main, NULL) != 0) {
+                fprintf(stderr, "fft_set_threads: started %d of %d workers\n", i, wanted);
+                break;
+            }
+            n_workers++;
+        }
+    }
+    pthread_mutex_unlock(&dispatch_lock);
+}
+
+int fft_get_threads(void) {
+    return atomic_load(&n_workers) + 1;
+}
+
+void parallel_for(const int count, const int grain, const parallel_fn fn, void* ctx) {
+    if (count <= 0) {
+        return;
+    }
+    if (inside_job || pthread_mutex_trylock(&dispatch_lock) != 0) {
+        fn(ctx, 0, count, 0);
+        return;
+    }
+    if (n_workers == 0) {
+        pthread_mutex_unlock(&dispatch_lock);
+        fn(ctx, 0, count, 0);
+        return;
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    job.fn = fn;
+    job.ctx = ctx;
+    job.count = count;
+    job.grain = grain > 0 ? grain : 1;
+    job.n_chunks = n_workers + 1;
+    job.next_chunk = 0;
+    job.pending = job.n_chunks;
+    generation++;
+    pthread_cond_broadcast(&work_ready);
+
+    run_chunks();
+    while (job.pending > 0) {
+        pthread_cond_wait(&work_done, &pool_lock);
+    }
+    pthread_mutex_unlock(&pool_lock);
+    pthread_mutex_unlock(&dispatch_lock);
+}
@@ -0,0 +1,24 @@
+#ifndef THREADS_H
+#define THREADS_H
+
+/*
+ * THREAD POOL
+ * A process-wide pool of fft_get_threads() - 1 worker threads; the calling
+ * thread works as the last member. The default of 1 thread runs everything
+ * on the caller.
+ */
+void fft_set_threads(int n_threads);
+
+int fft_get_threads(void);
+
+/* fn(ctx, begin, end, thread) handles the items [begin, end); thread is in [0, fft_get_threads()). */
+typedef void (*parallel_fn)(void* ctx, int begin, int end, int thread);
+
+/*
+ * Splits [0, count) into one contiguous chunk per thread, runs them on the pool
+ * and returns when all are done. Chunk boundaries are multiples of grain.
+ * Nested or concurrent calls run serially on the calling thread.
+ */
+void parallel_for(int count, int grain, parallel_fn fn, void* ctx);
+
+#endif //THREADS_H
@@ -4,6 +4,10 @@
 #include <math.h>
 #include <stddef.h>
 #include <stdlib.h>
+#include <string.h>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
 
 #include "complex.h"
 #include "stdio.h"
@@ -34,8 +38,39 @@ int next_power_of_two(const int x) {
     return (int) pow(2, ceil(log2(x)));
 }
 
+int largest_prime_factor(int x) {
+    int largest = 1;
+    for (int p = 2; p * p <= x; p++) {
+        while (x % p == 0) {
+            largest = p;
+            x /= p;
+        }
+    }
+    return x > 1 ? x : largest;
+}
+
+void* fft_malloc(size_t size) {
+    if (size == 0) {
+        size = 1;
+    }
+#ifdef _WIN32
+    return _aligned_malloc(size, FFT_ALIGNMENT);
+#else
+    void* ptr;
+    return posix_memalign(&ptr, FFT_ALIGNMENT, size) == 0 ? ptr : NULL;
+#endif
+}
+
+void fft_free(void* ptr) {
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    free(ptr);
+#endif
+}
+
 struct Complex* malloc_cplx_arr(const int N) {
-    struct Complex* arr = malloc(N * sizeof(struct Complex));
+    struct Complex* arr = fft_malloc(N * sizeof(struct Complex));
     if (arr == NULL) {
         printf("malloc_cplx_arr failed\n");
     }
@@ -43,50 +78,47 @@ struct Complex* malloc_cplx_arr(const int N) {
 }
 
 struct Complex* calloc_cplx_arr(const int N) {
-    struct Complex* arr = calloc(N, sizeof(struct Complex));
+    struct Complex* arr = fft_malloc(N * sizeof(struct Complex));
     if (arr == NULL) {
         fprintf(stderr, "calloc_cplx_arr failed\n");
+        return NULL;
     }
+    memset(arr, 0, N * sizeof(struct Complex));
     return arr;
 }
 
-struct Complex** malloc_2d_cplx_arr(const int height, const int width) {
-    struct Complex** x = malloc(height * sizeof(struct Complex*));
+/* Elements start at the first aligned boundary after the header. */
+static const size_t CPLX_2D_HEADER_SIZE = (sizeof(struct Complex2D) + FFT_ALIGNMENT - 1) / FFT_ALIGNMENT * FFT_ALIGNMENT;
+
+/* Rows are padded to whole cache lines. */
+static const int CPLX_2D_ROW_ALIGN = FFT_ALIGNMENT / sizeof(struct Complex);
+
+struct Complex2D* malloc_2d_cplx_arr(const int height, const int width) {
+    const int stride = (width + CPLX_2D_ROW_ALIGN - 1) / CPLX_2D_ROW_ALIGN * CPLX_2D_ROW_ALIGN;
+    const size_t count = (size_t) height * stride;
+    struct Complex2D* x = fft_malloc(CPLX_2D_HEADER_SIZE + count * sizeof(struct Complex));
     if (x == NULL) {
         fprintf(stderr, "malloc_2d_cplx_arr failed\n");
         return NULL;
     }
-    for (int i = 0; i < height; i++) {
-        x[i] = (struct Complex*) malloc(width * sizeof(struct Complex));
-        if (x[i] == NULL) {
-            fprintf(stderr, "malloc_2d_cplx_arr failed at row initialization\n");
-            return NULL;
-        }
-    }
+    x->data = (struct Complex*) ((char*) x + CPLX_2D_HEADER_SIZE);
+    x->height = height;
+    x->width = width;
+    x->stride = stride;
     return x;
 }
 
-struct Complex** calloc_2d_cplx_arr(const int height, const int width) {
-    struct Complex** x = calloc(height, sizeof(struct Complex*));
-   if (x == NULL) {
-       fprintf(stderr, "calloc_2d_cplx_arr failed\n");
-       return NULL;
-   }
-    for (int i = 0; i < height; i++) {
-        x[i] = (struct Complex*) calloc(width, sizeof(struct Complex));
-        if (x[i] == NULL) {
-            fprintf(stderr, "calloc_2d_cplx_arr failed at row initialization\n");
-            return NULL;
-        }
+struct Complex2D* calloc_2d_cplx_arr(const int height, const int width) {
+    struct Complex2D* x = malloc_2d_cplx_arr(height, width);
+    if (x == NULL) {
+        return NULL;
     }
+    memset(x->data, 0, (size_t) height * x->stride * sizeof(struct Complex));
     return x;
 }
 
-void free_2d(struct Complex** arr, const int height) {
-    for (int i = 0; i < height; i++) {
-        free(arr[i]);
-    }
-    free(arr);
+void free_2d(struct Complex2D* arr) {
+    fft_free(arr);
 }
 
 struct Complex* to_cplx_arr(const double *to_convert, const int N) {
@@ -97,11 +129,15 @@ struct Complex* to_cplx_arr(const double *to_convert, const int N) {
     return complex_array;
 }
 
-struct Complex** to_2d_cplx_arr(const double *src, const int height, const int width) {
-    struct Complex** x = calloc_2d_cplx_arr(height, width);
+struct Complex2D* to_2d_cplx_arr(const double *src, const int height, const int width) {
+    struct Complex2D* x = malloc_2d_cplx_arr(height, width);
+    if (x == NULL) {
+        return NULL;
+    }
     for (int i = 0; i < height; i++) {
+        struct Complex* row = cplx_2d_row(x, i);
         for (int j = 0; j < width; j++) {
-            x[i][j].real = src[i * width + j];
+            row[j] = (struct Complex){src[i * width + j], 0};
         }
     }
     return x;
@@ -120,6 +156,26 @@ double* to_double_arr(const struct Complex* src, const int N) {
     return double_array;
 }
 
+struct Complex* split_to_cplx_arr(const double* re, const double* im, const int N) {
+    struct Complex* complex_array = malloc_cplx_arr(N);
+    if (complex_array == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < N; i++) {
+        complex_array[i] = (struct Complex){re[i], im != NULL ? im[i] : 0};
+    }
+    return complex_array;
+}
+
+void to_split_arr(const struct Complex* src, double* re, double* im, const int N) {
+    for (int i = 0; i < N; i++) {
+        re[i] = src[i].real;
+        if (im != NULL) {
+            im[i] = src[i].imag;
+        }
+    }
+}
+
 void print_cplx(const struct Complex *x) {
     printf("%s%.*f %s%.*fi",
         x->real >= 0 ? " " : "",
@@ -152,11 +208,14 @@ void print_cplx_arr(const struct Complex* x, const int N) {
     printf(" ]\nsize=%d\n", N);
 }
 
-void print_2d_cplx_arr(struct Complex** x, const int height, const int width) {
+void print_2d_cplx_arr(const struct Complex2D* x) {
+    const int height = x->height;
+    const int width = x->width;
     assert(height >= 0 && width >= 0);
     for (int i = 0; i < height; i++) {
+        const struct Complex* row = cplx_2d_row(x, i);
         for (int j = 0; j < width; j++) {
-            print_cplx(&x[i][j]);
+            print_cplx(&row[j]);
             if (j != width - 1) {
                 printf(", ");
             }
@@ -185,7 +244,9 @@ double* to_grayscale(const unsigned char* img, const int height, const int width
     return grayscale;
 }
 
-double* to_amplitude_arr(struct Complex** x, const int height, const int width) {
+double* to_amplitude_arr(const struct Complex2D* x) {
+    const int height = x->height;
+    const int width = x->width;
     double* flat_amp_arr = malloc(height * width * sizeof(double));
     if (flat_amp_arr == NULL) {
         fprintf(stderr, "to_amplitude_arr failed\n");
@@ -193,8 +254,46 @@ double* to_amplitude_arr(struct Complex** x, const int height, const int width)
     }
 
     for (int i = 0; i < height; i++) {
+        const struct Complex* row = cplx_2d_row(x, i);
+        for (int j = 0; j < width; j++) {
+            flat_amp_arr[i * width + j] = log(1 + amplitude_q(row[j]));
+        }
+    }
+    return flat_amp_arr;
+}
+
+double* split_to_amplitude_arr(const double* re, const double* im, const int height, const int width) {
+    double* flat_amp_arr = malloc(height * width * sizeof(double));
+    if (flat_amp_arr == NULL) {
+        fprintf(stderr, "split_to_amplitude_arr failed\n");
+        return NULL;
+    }
+
+    for (int i = 0; i < height * width; i++) {
+        const struct Complex x = {re[i], im != NULL ? im[i] : 0};
+        flat_amp_arr[i] = log(1 + amplitude_q(x));
+    }
+    return flat_amp_arr;
+}
+
+double* to_amplitude_arr_half(const struct Complex2D* x, const int width) {
+    const int height = x->height;
+    double* flat_amp_arr = malloc(height * width * sizeof(double));
+    if (flat_amp_arr == NULL) {
+        fprintf(stderr, "to_amplitude_arr_half failed\n");
+        return NULL;
+    }
+
+    /* Hermitian symmetry: |X[i][j]| = |X[-i mod height][width - j]| for the bins that are not stored. */
+    const int half_width = width / 2;
+    for (int i = 0; i < height; i++) {
+        const struct Complex* row = cplx_2d_row(x, i);
+        const struct Complex* mirror_row = cplx_2d_row(x, (height - i) % height);
         for (int j = 0; j < width; j++) {
-            flat_amp_arr[i * width + j] = log(1 + amplitude_q(x[i][j]));
+            const double amplitude = j <= half_width
+                ? amplitude_q(row[j])
+                : amplitude_q(mirror_row[width - j]);
+            flat_amp_arr[i * width + j] = log(1 + amplitude);
         }
     }
     return flat_amp_arr;
@@ -1,5 +1,20 @@
 #ifndef UTIL_H
 #define UTIL_H
+#include <stddef.h>
+
+#include "complex.h"
+
+/* Row-major 2D complex array; header and elements come from a single aligned allocation released by free_2d. */
+struct Complex2D {
+    struct Complex* data;
+    int height;
+    int width;
+    int stride;     /* elements between the starts of consecutive rows, >= width */
+};
+
+static inline struct Complex* cplx_2d_row(const struct Complex2D* x, const int i) {
+    return x->data + (size_t) i * x->stride;
+}
 
 /* FFT UTILITIES */
 int bit_reverse(int x, int bits);
@@ -8,24 +23,44 @@ struct Complex* bit_reverse_arr(const struct Complex* x, int N);
 
 int next_power_of_two(int x);
 
-/* MEMORY ALLOCATION */
+int largest_prime_factor(int x);
+
+/*
+ * MEMORY ALLOCATION
+ * Complex buffers are FFT_ALIGNMENT-byte aligned (a cache line, and a full
+ * AVX-512 vector), and 2D rows are padded so every row starts aligned.
+ * Release them with fft_free; on POSIX systems free() works as well.
+ */
+#define FFT_ALIGNMENT 64
+
+/* Aligned allocation for callers' own buffers; NULL on failure. */
+void* fft_malloc(size_t size);
+
+void fft_free(void* ptr);
+
 struct Complex* malloc_cplx_arr(int N);
 
 struct Complex* calloc_cplx_arr(int N);
 
-struct Complex** malloc_2d_cplx_arr(int height, int width);
+struct Complex2D* malloc_2d_cplx_arr(int height, int width);
 
-struct Complex** calloc_2d_cplx_arr(int height, int width);
+struct Complex2D* calloc_2d_cplx_arr(int height, int width);
 
-void free_2d(struct Complex** arr, int height);
+void free_2d(struct Complex2D* arr);
 
 /* CONVERSIONS */
 struct Complex* to_cplx_arr(const double *to_convert, int N);
 
-struct Complex** to_2d_cplx_arr(const double *src, int height, int width);
+struct Complex2D* to_2d_cplx_arr(const double *src, int height, int width);
 
 double* to_double_arr(const struct Complex* src, int N);
 
+/* Split complex: real and imaginary parts in separate arrays; a NULL imaginary array means all zeros. */
+struct Complex* split_to_cplx_arr(const double* re, const double* im, int N);
+
+/* im may be NULL to keep only the real parts, as to_double_arr. */
+void to_split_arr(const struct Complex* src, double* re, double* im, int N);
+
 /* OUTPUT FORMATTING */
 void print_cplx(const struct Complex *x);
 
@@ -33,11 +68,17 @@ void print_double_arr(const double *x, int N);
 
 void print_cplx_arr(const struct Complex* x, int N);
 
-void print_2d_cplx_arr(struct Complex** x, int height, int width);
+void print_2d_cplx_arr(const struct Complex2D* x);
 
 double* to_grayscale(const unsigned char* img, int height, int width, int ch);
 
-double* to_amplitude_arr(struct Complex** x, int height, int width);
+double* to_amplitude_arr(const struct Complex2D* x);
+
+/* to_amplitude_arr of a flat height x width split-complex plane. */
+double* split_to_amplitude_arr(const double* re, const double* im, int height, int width);
+
+/* Full height x width amplitude plane from a height x (width/2 + 1) half spectrum of a real input. */
+double* to_amplitude_arr_half(const struct Complex2D* x, int width);
 
 unsigned char* to_char_arr(const double* x, int height, int width);
 
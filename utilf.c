@@ -0,0 +1,131 @@
+#include "utilf.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "complex.h"
+#include "complexf.h"
+#include "util.h"
+
+struct ComplexF* malloc_cplxf_arr(const int N) {
+    struct ComplexF* arr = fft_malloc(N * sizeof(struct ComplexF));
+    if (arr == NULL) {
+        fprintf(stderr, "malloc_cplxf_arr failed\n");
+    }
+    return arr;
+}
+
+struct ComplexF* calloc_cplxf_arr(const int N) {
+    struct ComplexF* arr = fft_malloc(N * sizeof(struct ComplexF));
+    if (arr == NULL) {
+        fprintf(stderr, "calloc_cplxf_arr failed\n");
+        return NULL;
+    }
+    memset(arr, 0, N * sizeof(struct ComplexF));
+    return arr;
+}
+
+/* Elements start at the first aligned boundary after the header. */
+static const size_t CPLXF_2D_HEADER_SIZE = (sizeof(struct Complex2DF) + FFT_ALIGNMENT - 1) / FFT_ALIGNMENT * FFT_ALIGNMENT;
+
+/* Rows are padded to whole cache lines. */
+static const int CPLXF_2D_ROW_ALIGN = FFT_ALIGNMENT / sizeof(struct ComplexF);
+
+struct Complex2DF* malloc_2d_cplxf_arr(const int height, const int width) {
+    const int stride = (width + CPLXF_2D_ROW_ALIGN - 1) / CPLXF_2D_ROW_ALIGN * CPLXF_2D_ROW_ALIGN;
+    const size_t count = (size_t) height * stride;
+    struct Complex2DF* x = fft_malloc(CPLXF_2D_HEADER_SIZE + count * sizeof(struct ComplexF));
+    if (x == NULL) {
+        fprintf(stderr, "malloc_2d_cplxf_arr failed\n");
+        return NULL;
+    }
+    x->data = (struct ComplexF*) ((char*) x + CPLXF_2D_HEADER_SIZE);
+    x->height = height;
+    x->width = width;
+    x->stride = stride;
+    return x;
+}
+
+void free_2df(struct Complex2DF* arr) {
+    fft_free(arr);
+}
+
+struct ComplexF* to_cplxf_arr(const float* to_convert, const int N) {
+    struct ComplexF* complex_array = calloc_cplxf_arr(N);
+    if (complex_array == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < N; i++) {
+        complex_array[i].real = to_convert[i];
+    }
+    return complex_array;
+}
+
+struct Complex2DF* to_2d_cplxf_arr(const float* src, const int height, const int width) {
+    struct Complex2DF* x = malloc_2d_cplxf_arr(height, width);
+    if (x == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < height; i++) {
+        struct ComplexF* row = cplxf_2d_row(x, i);
+        for (int j = 0; j < width; j++) {
+            row[j] = (struct ComplexF){src[i * width + j], 0};
+        }
+    }
+    return x;
+}
+
+float* to_float_arr(const struct ComplexF* src, const int N) {
+    float* float_array = malloc(N * sizeof(float));
+    if (float_array == NULL) {
+        fprintf(stderr, "to_float_arr failed\n");
+        return NULL;
+    }
+    for (int i = 0; i < N; i++) {
+        float_array[i] = src[i].real;
+    }
+    return float_array;
+}
+
+struct ComplexF* cplx_to_cplxf_arr(const struct Complex* src, const int N) {
+    struct ComplexF* arr = malloc_cplxf_arr(N);
+    if (arr == NULL) {
+        return NULL;
+    }
+    for (int i = 0; i < N; i++) {
+        arr[i] = (struct ComplexF){(float) src[i].real, (float) src[i].imag};
+    }
+    return arr;
+}
+
+struct Complex* cplxf_to_cplx_arr(const struct ComplexF* src, const int N) {
+    struct Complex* arr = fft_malloc(N * sizeof(struct Complex));
+    if (arr == NULL) {
+        fprintf(stderr, "cplxf_to_cplx_arr failed\n");
+        return NULL;
+    }
+    for (int i = 0; i < N; i++) {
+        arr[i] = (struct Complex){src[i].real, src[i].imag};
+    }
+    return arr;
+}
+
+float* to_amplitude_arrf(const struct Complex2DF* x) {
+    const int height = x->height;
+    const int width = x->width;
+    float* flat_amp_arr = malloc((size_t) height * width * sizeof(float));
+    if (flat_amp_arr == NULL) {
+        fprintf(stderr, "to_amplitude_arrf failed\n");
+        return NULL;
+    }
+
+    for (int i = 0; i < height; i++) {
+        const struct ComplexF* row = cplxf_2d_row(x, i);
+        for (int j = 0; j < width; j++) {
+            flat_amp_arr[i * width + j] = log1pf(amplitude_qf(row[j]));
+        }
+    }
+    return flat_amp_arr;
+}
\ No newline at end of file
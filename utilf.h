@@ -0,0 +1,47 @@
+#ifndef UTILF_H
+#define UTILF_H
+#include <stddef.h>
+
+#include "complex.h"
+#include "complexf.h"
+
+/* Single-precision counterparts of the util.h arrays and conversions; buffers are aligned as there and released with fft_free. */
+
+/* Row-major 2D float complex array; header and elements come from a single aligned allocation released by free_2df. */
+struct Complex2DF {
+    struct ComplexF* data;
+    int height;
+    int width;
+    int stride;     /* elements between the starts of consecutive rows, >= width */
+};
+
+static inline struct ComplexF* cplxf_2d_row(const struct Complex2DF* x, const int i) {
+    return x->data + (size_t) i * x->stride;
+}
+
+/* MEMORY ALLOCATION */
+struct ComplexF* malloc_cplxf_arr(int N);
+
+struct ComplexF* calloc_cplxf_arr(int N);
+
+struct Complex2DF* malloc_2d_cplxf_arr(int height, int width);
+
+void free_2df(struct Complex2DF* arr);
+
+/* CONVERSIONS */
+struct ComplexF* to_cplxf_arr(const float* to_convert, int N);
+
+struct Complex2DF* to_2d_cplxf_arr(const float* src, int height, int width);
+
+/* Taking the real component of the complex element only */
+float* to_float_arr(const struct ComplexF* src, int N);
+
+/* Between precisions. */
+struct ComplexF* cplx_to_cplxf_arr(const struct Complex* src, int N);
+
+struct Complex* cplxf_to_cplx_arr(const struct ComplexF* src, int N);
+
+/* log(1 + |x|) per element, flattened row-major, as to_amplitude_arr. */
+float* to_amplitude_arrf(const struct Complex2DF* x);
+
+#endif //UTILF_H